@@ -0,0 +1,49 @@
+import torch
+import nestedtensor
+import utils
+
+import random
+import threading
+
+# Runs the same model on a single shared NestedTensor from several threads
+# and reports the throughput in forward passes per second. NestedTensors are
+# immutable, so the threads don't need to copy or lock the input.
+RAND_INTS = [random.randint(10, 300) for _ in range(64)]
+EMBED_DIM = 256
+RUNS_PER_THREAD = 20
+
+
+def gen_model():
+    return torch.nn.Sequential(
+        torch.nn.Linear(EMBED_DIM, EMBED_DIM),
+        torch.nn.ReLU(),
+        torch.nn.Linear(EMBED_DIM, EMBED_DIM)).eval()
+
+
+def gen_inference(num_threads):
+    nt = nestedtensor.nested_tensor(
+        [torch.rand(i, EMBED_DIM) for i in RAND_INTS])
+    model = gen_model()
+
+    def run():
+        with torch.no_grad():
+            for _ in range(RUNS_PER_THREAD):
+                torch.nn.functional.softmax(model(nt), 2)
+
+    def inference():
+        threads = [threading.Thread(target=run) for _ in range(num_threads)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    inference.__name__ = "inference_{}_threads".format(num_threads)
+    return inference
+
+
+if __name__ == "__main__":
+    torch.set_num_threads(1)
+    for num_threads in [1, 2, 4, 8]:
+        result = utils.benchmark_fn(gen_inference(num_threads))
+        result['forward_per_s'] = (num_threads * RUNS_PER_THREAD /
+                                   (result['avg_us'] / 1e6))
+        print(result)
@@ -0,0 +1,155 @@
+// Times the primitives of the tree layer (nested_node.h and
+// nested_node_functions.h) as well as NestedTensorImpl construction without
+// any interpreter in the way.
+//
+// Usage: nested_node_bench [run_time_seconds]
+//
+// Prints a JSON list with one entry per primitive and tree shape. Each entry
+// carries the same timing keys as benchmark_fn in benchmarks/utils.py.
+
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace torch::nested_tensor;
+
+namespace {
+
+// Results are accumulated here so that the work can't be optimized away.
+int64_t sink = 0;
+bool first_entry = true;
+
+struct TreeShape {
+  int64_t height;
+  int64_t degree;
+};
+
+template <typename T, typename F>
+NestedNode<T> build_tree(
+    int64_t height,
+    int64_t degree,
+    F& leaf_fn,
+    int64_t& index) {
+  if (height == 0) {
+    return NestedNode<T>(leaf_fn(index++));
+  }
+  std::vector<NestedNode<T>> children;
+  for (int64_t i = 0; i < degree; i++) {
+    children.push_back(build_tree<T>(height - 1, degree, leaf_fn, index));
+  }
+  return NestedNode<T>(std::move(children));
+}
+
+template <typename T, typename F>
+NestedNode<T> build_tree(TreeShape shape, F leaf_fn) {
+  int64_t index = 0;
+  return build_tree<T>(shape.height, shape.degree, leaf_fn, index);
+}
+
+template <typename F>
+void run(
+    const std::string& name,
+    TreeShape shape,
+    int64_t leaves,
+    double run_time,
+    F&& fn) {
+  // Warm up caches and the allocator.
+  auto warmup_end =
+      std::chrono::steady_clock::now() + std::chrono::duration<double>(0.1);
+  while (std::chrono::steady_clock::now() < warmup_end) {
+    fn();
+  }
+  std::vector<double> times;
+  double total = 0;
+  while (total < run_time || times.size() < 3) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(stop - start).count();
+    times.push_back(us);
+    total += us / 1e6;
+  }
+  double mean = 0;
+  for (double t : times) {
+    mean += t;
+  }
+  mean /= times.size();
+  double var = 0;
+  for (double t : times) {
+    var += (t - mean) * (t - mean);
+  }
+  double std_us = std::sqrt(var / (times.size() - 1));
+
+  std::cout << (first_entry ? "[\n" : ",\n");
+  first_entry = false;
+  std::cout << "  {\"name\": \"" << name << "\", \"height\": " << shape.height
+            << ", \"degree\": " << shape.degree << ", \"leaves\": " << leaves
+            << ", \"avg_us\": " << mean << ", \"std_us\": " << std_us
+            << ", \"runs\": " << times.size() << "}";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  double run_time = argc > 1 ? std::atof(argv[1]) : 1.0;
+  std::vector<TreeShape> shapes = {{1, 16},
+                                   {1, 1024},
+                                   {1, 65536},
+                                   {2, 16},
+                                   {2, 256},
+                                   {3, 16},
+                                   {3, 40},
+                                   {4, 16}};
+  for (TreeShape shape : shapes) {
+    int64_t leaves = std::pow(shape.degree, shape.height);
+
+    IntegerNode tree =
+        build_tree<int64_t>(shape, [](int64_t i) { return i; });
+    TensorNode tensor_tree = build_tree<at::Tensor>(
+        shape, [](int64_t i) { return at::ones({i % 7 + 1, 16}); });
+    c10::List<int64_t> flat = flatten(tree);
+
+    run("map", shape, leaves, run_time, [&tree]() {
+      sink += map([](int64_t x) { return x + 1; }, tree).degree();
+    });
+    run("reduce", shape, leaves, run_time, [&tree]() {
+      auto fn = [](int64_t x, int64_t acc) { return acc + x; };
+      sink += reduce<decltype(fn), int64_t, int64_t>(tree, fn, 0);
+    });
+    run("apply", shape, leaves, run_time, [&tree]() {
+      apply([](int64_t x) { sink += x; }, tree);
+    });
+    run("flatten", shape, leaves, run_time, [&tree]() {
+      sink += flatten(tree).size();
+    });
+    run("unflatten", shape, leaves, run_time, [&tree, &flat]() {
+      sink += unflatten(tree, flat).degree();
+    });
+    run("zip", shape, leaves, run_time, [&tree]() {
+      sink += zip(std::vector<IntegerNode>{tree, tree}).degree();
+    });
+    run("shape_matches", shape, leaves, run_time, [&tree]() {
+      sink += shape_matches(tree, tree);
+    });
+    run("nested_size_table", shape, leaves, run_time, [&tensor_tree]() {
+      sink += nested_size_table(tensor_tree).num_leaves();
+    });
+    SizeTable size_table = nested_size_table(tensor_tree);
+    run("construct_size", shape, leaves, run_time, [&size_table]() {
+      sink += construct_size(size_table).size();
+    });
+    run("nested_tensor_impl", shape, leaves, run_time, [&tensor_tree]() {
+      TensorNode structure = tensor_tree;
+      sink += at::wrap_tensor_node(std::move(structure)).dim();
+    });
+  }
+  std::cout << "\n]" << std::endl;
+  // Keeps sink alive without polluting the JSON on stdout.
+  std::cerr << "checksum: " << sink << std::endl;
+  return 0;
+}
@@ -0,0 +1,78 @@
+import torch
+import nestedtensor
+
+import argparse
+import random
+import threading
+import time
+
+# Synthetic load for DynamicBatcher: client threads submit requests of random
+# length at exponentially distributed intervals, while a single server thread
+# runs a small model on each batch. Reports throughput, batch sizes and the
+# latency percentiles seen by the clients.
+EMBED_DIM = 256
+
+
+def client(batcher, num_requests, rate, latencies):
+    requests = []
+    for _ in range(num_requests):
+        time.sleep(random.expovariate(rate))
+        tensor = torch.rand(random.randint(1, 128), EMBED_DIM)
+        requests.append((time.monotonic(), batcher.submit(tensor)))
+    for start, request in requests:
+        request.wait()
+        # Includes the time until this client got around to waiting, which
+        # is an upper bound of the latency.
+        latencies.append(time.monotonic() - start)
+
+
+def run(max_tokens, max_latency_ms, num_clients, num_requests, rate):
+    model = torch.nn.Sequential(
+        torch.nn.Linear(EMBED_DIM, EMBED_DIM),
+        torch.nn.ReLU(),
+        torch.nn.Linear(EMBED_DIM, EMBED_DIM)).eval()
+    batcher = nestedtensor.DynamicBatcher(max_tokens, max_latency_ms)
+    batch_sizes = []
+
+    def fn(batch):
+        batch_sizes.append(len(batch))
+        with torch.no_grad():
+            return model(batch)
+
+    server = threading.Thread(target=batcher.serve, args=(fn,))
+    server.start()
+    latencies = []
+    clients = [threading.Thread(target=client,
+                                args=(batcher, num_requests, rate, latencies))
+               for _ in range(num_clients)]
+    start = time.monotonic()
+    for c in clients:
+        c.start()
+    for c in clients:
+        c.join()
+    elapsed = time.monotonic() - start
+    batcher.close()
+    server.join()
+
+    latencies = torch.tensor(latencies) * 1e3
+    return {
+        'max_tokens': max_tokens,
+        'max_latency_ms': max_latency_ms,
+        'requests_per_s': len(latencies) / elapsed,
+        'avg_batch_size': sum(batch_sizes) / len(batch_sizes),
+        'p50_ms': latencies.quantile(0.5).item(),
+        'p99_ms': latencies.quantile(0.99).item(),
+    }
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--clients", type=int, default=8)
+    parser.add_argument("--requests", type=int, default=200)
+    parser.add_argument("--rate", type=float, default=500.0,
+                        help="Requests per second and client.")
+    args = parser.parse_args()
+    for max_tokens in [512, 2048, 8192]:
+        for max_latency_ms in [1, 5, 20]:
+            print(run(max_tokens, max_latency_ms, args.clients,
+                      args.requests, args.rate))
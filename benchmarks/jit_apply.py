@@ -36,32 +36,23 @@ def gen_current():
 
 
 def gen_jit():
-
-    n = nestedtensor._C._ListNestedTensor(
+    n = nestedtensor.as_nested_tensor(
         [torch.randn(256, 128).to(device='cuda') for _ in range(128)])
 
-    def gen_my_fun(scalar, tensor):
-        @torch.jit.ignore
-        def get_scalar():
-            return scalar
+    def _algorithm_jit():
+        n.jit_apply(my_fun)
 
-        @torch.jit.ignore
-        def get_tensor():
-            return tensor
+    return _algorithm_jit
 
-        @torch.jit.script
-        def my_fun(x, y):
-            x = x + get_scalar()
-            x = x + get_tensor()
-            y = y + x.abs()
-            return y
-        return my_fun
-    my_fun = gen_my_fun(3.0, torch.randn(1).to(device='cuda'))
 
-    def _algorithm_jit():
-        nestedtensor._C.jit_apply_function((n, n), my_fun)
+def gen_jit_batch():
+    n = nestedtensor.as_nested_tensor(
+        [torch.randn(256, 128).to(device='cuda') for _ in range(128)])
 
-    return _algorithm_jit
+    def _algorithm_jit_batch():
+        n.jit_apply(my_fun, batch=True)
+
+    return _algorithm_jit_batch
 
 
 if __name__ == "__main__":
@@ -72,3 +63,5 @@ if __name__ == "__main__":
     print(utils.benchmark_fn(alg1))
     alg2 = gen_jit()
     print(utils.benchmark_fn(alg2))
+    alg3 = gen_jit_batch()
+    print(utils.benchmark_fn(alg3))
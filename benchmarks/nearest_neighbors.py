@@ -86,6 +86,18 @@ def gen_algorithm_nested_jit_mv(keys, sub_clusters):
         return my_fun(nested_sub_clusters, nested_keys)
     return _nested_jit_mv
 
+def gen_algorithm_nested_quantized_mm(keys, sub_clusters):
+    # int8 clusters times all keys at once. Quantization is CPU only.
+    clusters = [torch.stack(cluster).cpu()
+                for sub_cluster in sub_clusters for cluster in sub_cluster]
+    quantized_clusters = nestedtensor.quantize(
+        nestedtensor.nested_tensor(clusters), per_row=True)
+    key_matrix = torch.stack(keys).cpu().t().contiguous()
+    def _nested_quantized_mm():
+        return quantized_clusters.matmul(key_matrix)
+    return _nested_quantized_mm
+
+
 
 def print_results(results, keys, sub_clusters, print_details=False):
     if print_details:
@@ -136,11 +148,13 @@ if __name__ == "__main__":
     gen_results_naive = gen_algorithm_naive(keys, sub_clusters)
     gen_results_mv = gen_algorithm_mv(keys, sub_clusters)
     gen_results_nested_mv = gen_algorithm_nested_mv(keys, sub_clusters)
+    gen_results_nested_quantized_mm = gen_algorithm_nested_quantized_mm(keys, sub_clusters)
     # gen_results_nested_jit_mv = gen_algorithm_nested_jit_mv(keys, sub_clusters)
 
     print(benchmark_fn(gen_results_nested_mv))
     print(benchmark_fn(gen_results_naive))
     print(benchmark_fn(gen_results_mv))
+    print(benchmark_fn(gen_results_nested_quantized_mm))
     # print(benchmark_fn(gen_results_nested_jit_mv))
     # import cProfile, pstats, io
     # pr = cProfile.Profile()
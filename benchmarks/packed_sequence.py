@@ -0,0 +1,49 @@
+import torch
+import nestedtensor
+import utils
+
+import random
+
+from torch.nn.utils.rnn import pack_padded_sequence, pad_packed_sequence
+
+# Compares running an LSTM over a NestedTensor via padding, i.e.
+# to_tensor_mask, pack_padded_sequence and pad_packed_sequence, with the
+# native PackedSequence conversion.
+RAND_INTS = [random.randint(10, 300) for _ in range(64)]
+EMBED_DIM = 256
+
+
+def gen_nt():
+    return nestedtensor.nested_tensor(
+        [torch.rand(i, EMBED_DIM) for i in RAND_INTS])
+
+
+def gen_padded():
+    nt = gen_nt()
+    lstm = torch.nn.LSTM(EMBED_DIM, EMBED_DIM)
+
+    def padded():
+        tensor, mask = nt.to_tensor_mask(mask_dim=2)
+        lengths = mask.sum(1)
+        packed = pack_padded_sequence(
+            tensor, lengths, batch_first=True, enforce_sorted=False)
+        output, _ = lstm(packed)
+        output, _ = pad_packed_sequence(output, batch_first=True)
+        return nestedtensor.nested_tensor(
+            [o[:l] for o, l in zip(output.unbind(), lengths.tolist())])
+    return padded
+
+
+def gen_native():
+    nt = gen_nt()
+    lstm = torch.nn.LSTM(EMBED_DIM, EMBED_DIM)
+
+    def native():
+        return nestedtensor.nn.lstm(lstm, nt)
+    return native
+
+
+if __name__ == "__main__":
+    with torch.no_grad():
+        print(utils.benchmark_fn(gen_padded()))
+        print(utils.benchmark_fn(gen_native()))
@@ -0,0 +1,44 @@
+import torch
+import nestedtensor
+import utils
+
+import random
+
+# Compares torch.matmul on a float32 NestedTensor with the int8 quantized
+# matmul on the same data, along with the error of the quantized result.
+RAND_INTS = [random.randint(10, 300) for _ in range(64)]
+EMBED_DIM = 512
+OUT_DIM = 512
+
+
+def gen_nt():
+    return nestedtensor.nested_tensor(
+        [torch.rand(i, EMBED_DIM) for i in RAND_INTS])
+
+
+def gen_float(weight):
+    nt = gen_nt()
+
+    def float_matmul():
+        return torch.matmul(nt, weight)
+    return float_matmul
+
+
+def gen_quantized(weight):
+    quantized = nestedtensor.quantize(gen_nt(), per_row=True)
+
+    def quantized_matmul():
+        return quantized.matmul(weight)
+    return quantized_matmul
+
+
+if __name__ == "__main__":
+    weight = torch.rand(EMBED_DIM, OUT_DIM)
+    print(utils.benchmark_fn(gen_float(weight)))
+    print(utils.benchmark_fn(gen_quantized(weight)))
+    nt = gen_nt()
+    expected = torch.matmul(nt, weight)
+    result = nestedtensor.quantize(nt, per_row=True).matmul(weight)
+    print("max abs error: {:.4f}".format(
+        max((e - r).abs().max().item()
+            for e, r in zip(expected.unbind(), result.unbind()))))
@@ -0,0 +1,74 @@
+import torch
+import nestedtensor
+import utils
+
+import random
+
+# Compares float32 storage with bfloat16 storage for the fused reductions,
+# which accumulate in float32 either way. Also reports the largest deviation
+# of the bfloat16 results from the float32 ones. On CPU softmax and
+# layer_norm convert bfloat16 constiuents to float32 and back, because ATen
+# has no reduced precision CPU kernels for them, so only CUDA saves memory
+# traffic there.
+RAND_INTS = [random.randint(10, 300) for _ in range(64)]
+EMBED_DIM = 1024
+
+
+def gen_nt(dtype):
+    nt = nestedtensor.nested_tensor(
+        [torch.rand(i, EMBED_DIM) for i in RAND_INTS])
+    return nt.to(dtype)
+
+
+def gen_to(dtype):
+    nt = gen_nt(torch.float32)
+
+    def to():
+        nt.to(dtype)
+    return to
+
+
+def gen_softmax(dtype):
+    nt = gen_nt(dtype)
+
+    def softmax():
+        torch.nn.functional.softmax(nt, 2)
+    return softmax
+
+
+def gen_layer_norm(dtype):
+    nt = gen_nt(dtype)
+
+    def layer_norm():
+        torch.nn.functional.layer_norm(nt, (EMBED_DIM,))
+    return layer_norm
+
+
+def gen_sum(dtype):
+    nt = gen_nt(dtype)
+
+    def sum_():
+        nt.sum()
+    return sum_
+
+
+def max_error():
+    nt = gen_nt(torch.float32)
+    nt_low = nt.to(torch.bfloat16)
+    errors = {}
+    for name, fn in [("softmax", lambda x: torch.nn.functional.softmax(x, 2)),
+                     ("layer_norm", lambda x: torch.nn.functional.layer_norm(x, (EMBED_DIM,)))]:
+        errors[name] = max((a - b.float()).abs().max().item()
+                           for a, b in zip(fn(nt).unbind(), fn(nt_low).unbind()))
+    errors["sum"] = (nt.sum() - nt_low.sum().float()).abs().item() / nt.sum().item()
+    return errors
+
+
+if __name__ == "__main__":
+    for dtype in [torch.float32, torch.bfloat16]:
+        print(dtype)
+        print(utils.benchmark_fn(gen_to(dtype)))
+        print(utils.benchmark_fn(gen_softmax(dtype)))
+        print(utils.benchmark_fn(gen_layer_norm(dtype)))
+        print(utils.benchmark_fn(gen_sum(dtype)))
+    print(max_error())
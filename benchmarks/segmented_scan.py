@@ -0,0 +1,38 @@
+import torch
+import nestedtensor
+import utils
+
+import random
+
+# Compares torch.cumsum applied to each constiuent with the segmented scan
+# over the packed layout, along the ragged dimension for several widths.
+RAND_INTS = [random.randint(10, 3000) for _ in range(256)]
+EMBED_DIMS = [1, 64, 1024]
+
+
+def gen_nt(embed_dim):
+    return nestedtensor.nested_tensor(
+        [torch.rand(i, embed_dim) for i in RAND_INTS])
+
+
+def gen_unbind(embed_dim):
+    nt = gen_nt(embed_dim)
+
+    def unbind():
+        return [torch.cumsum(t, 0) for t in nt.unbind()]
+    return unbind
+
+
+def gen_segmented(embed_dim):
+    nt = gen_nt(embed_dim)
+
+    def segmented():
+        return torch.cumsum(nt, 1)
+    return segmented
+
+
+if __name__ == "__main__":
+    for embed_dim in EMBED_DIMS:
+        print("embed_dim", embed_dim)
+        print(utils.benchmark_fn(gen_unbind(embed_dim)))
+        print(utils.benchmark_fn(gen_segmented(embed_dim)))
@@ -0,0 +1,111 @@
+import torch
+import nestedtensor
+import utils
+
+# Measures the time spent in the Python NestedTensor wrapper per op. The
+# NestedTensor is tiny, so that the kernels themselves are negligible.
+# "impl" calls the underlying NestedTensorImpl directly, "python" emulates
+# the previous pure Python wrapper and "wrapper" is the current one.
+
+
+def _py_wrap_result(result):
+    return (
+        nestedtensor.NestedTensor(result)
+        if torch.is_tensor(result) and torch.ops.nestedtensor.is_nested_tensor_impl(result)
+        else result
+    )
+
+
+def _py_filter_impl(args, kwargs):
+    if kwargs is None:
+        kwargs = {}
+    impl_args = [a._impl if isinstance(a, nestedtensor.NestedTensor) else a for a in args]
+    impl_kwargs = {
+        k: v._impl if isinstance(v, nestedtensor.NestedTensor) else v for (k, v) in kwargs.items()
+    }
+    return impl_args, impl_kwargs
+
+
+def _py_call_method(name, *args, **kwargs):
+    impl_args, impl_kwargs = _py_filter_impl(args, kwargs)
+    result = getattr(impl_args[0], name)(*(impl_args[1:]), **impl_kwargs)
+    return _py_wrap_result(result)
+
+
+def gen_nt():
+    return nestedtensor.nested_tensor([torch.rand(1)])
+
+
+def gen_impl_cos():
+    impl = gen_nt()._impl
+
+    def impl_cos():
+        impl.cos()
+    return impl_cos
+
+
+def gen_python_cos():
+    nt = gen_nt()
+
+    def python_cos():
+        _py_call_method("cos", nt)
+    return python_cos
+
+
+def gen_wrapper_cos():
+    nt = gen_nt()
+
+    def wrapper_cos():
+        nt.cos()
+    return wrapper_cos
+
+
+def gen_impl_mul():
+    impl = gen_nt()._impl
+
+    def impl_mul():
+        impl.mul(impl)
+    return impl_mul
+
+
+def gen_python_mul():
+    nt = gen_nt()
+
+    def python_mul():
+        _py_call_method("mul", nt, nt)
+    return python_mul
+
+
+def gen_wrapper_mul():
+    nt = gen_nt()
+
+    def wrapper_mul():
+        nt.mul(nt)
+    return wrapper_mul
+
+
+def gen_impl_torch_function():
+    impl = gen_nt()._impl
+
+    def impl_torch_function():
+        torch.cos(impl)
+    return impl_torch_function
+
+
+def gen_wrapper_torch_function():
+    nt = gen_nt()
+
+    def wrapper_torch_function():
+        torch.cos(nt)
+    return wrapper_torch_function
+
+
+if __name__ == "__main__":
+    print(utils.benchmark_fn(gen_impl_cos()))
+    print(utils.benchmark_fn(gen_python_cos()))
+    print(utils.benchmark_fn(gen_wrapper_cos()))
+    print(utils.benchmark_fn(gen_impl_mul()))
+    print(utils.benchmark_fn(gen_python_mul()))
+    print(utils.benchmark_fn(gen_wrapper_mul()))
+    print(utils.benchmark_fn(gen_impl_torch_function()))
+    print(utils.benchmark_fn(gen_wrapper_torch_function()))
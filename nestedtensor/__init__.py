@@ -2,10 +2,28 @@ import torch
 
 from .nested.creation import as_nested_tensor
 from .nested.creation import nested_tensor
+from .nested.creation import NestedTensorBuilder
 
 from .nested.masking import nested_tensor_from_tensor_mask
 from .nested.masking import nested_tensor_from_padded_tensor
 
+from .nested.serialization import save
+from .nested.serialization import load
+
+from .nested.sorting import sort_by_size
+from .nested.sorting import bucketize_by_size
+
+from .nested.quantization import quantize
+from .nested.quantization import QuantizedNestedTensor
+
+from .nested.batching import DynamicBatcher
+
+from .nested.dropout import dropout
+from .nested.dropout import dropout_mask
+
+from .nested.packed_sequence import to_packed_sequence
+from .nested.packed_sequence import from_packed_sequence
+
 from .nested.nested import NestedTensor
 
 from . import nested
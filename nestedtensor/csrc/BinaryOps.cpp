@@ -1,5 +1,7 @@
 #include <ATen/core/op_registration/op_registration.h>
+#include <nestedtensor/csrc/arena.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/profiling.h>
 #include <nestedtensor/csrc/utils/nested_node_functions.h>
 #include <torch/library.h>
 
@@ -36,6 +38,58 @@ Tensor NestedTensor_binary(const Tensor& self, const Tensor& other) {
           get_nested_tensor_structure(self)));
 }
 
+// NOTE: If both operands are NestedTensors with matching constiuent sizes
+// and the result is floating point, we can carve the result out of a single
+// arena block and write into it via the out variant.
+template <
+    Tensor (*func)(const Tensor&, const Tensor&),
+    Tensor& (*func_out)(Tensor&, const Tensor&, const Tensor&)>
+Tensor NestedTensor_binary_packed(const Tensor& self, const Tensor& other) {
+  if (!is_nested_tensor_impl(other)) {
+    NestedTensorOpScope::record_fallback();
+    return NestedTensor_binary<func>(self, other);
+  }
+  auto self_structure = get_nested_tensor_structure(self);
+  auto other_structure = get_nested_tensor_structure(other);
+  auto self_first = get_first_leaf(self_structure);
+  auto other_first = get_first_leaf(other_structure);
+  if (!self_first || !other_first ||
+      !shape_matches(self_structure, other_structure) ||
+      !arena_eligible(self_structure) || !arena_eligible(other_structure)) {
+    NestedTensorOpScope::record_fallback();
+    return NestedTensor_binary<func>(self, other);
+  }
+  ScalarType result_type = at::result_type(*self_first, *other_first);
+  bool same_sizes = all(
+      [](at::Tensor self, at::Tensor other) {
+        return self.sizes().equals(other.sizes());
+      },
+      self_structure,
+      other_structure);
+  if (!at::isFloatingType(result_type) || !same_sizes) {
+    NestedTensorOpScope::record_fallback();
+    return NestedTensor_binary<func>(self, other);
+  }
+  NestedTensor result = arena_empty_like(
+      self_structure, self_first->options().dtype(result_type));
+  if (is_packed(self) && is_packed(other)) {
+    at::Tensor result_buffer = *result.get_buffer();
+    func_out(
+        result_buffer,
+        *get_nested_tensor(self).get_buffer(),
+        *get_nested_tensor(other).get_buffer());
+    return wrap_nested_tensor(std::move(result));
+  }
+  apply(
+      [](Tensor& result, Tensor& tensor, Tensor& other) {
+        func_out(result, tensor, other);
+      },
+      result.get_structure(),
+      self_structure,
+      other_structure);
+  return wrap_nested_tensor(std::move(result));
+}
+
 template <typename S, Tensor (*func)(const Tensor&, const Tensor&, S)>
 Tensor NestedTensor_binary(const Tensor& self, const Tensor& other, S scalar) {
   if (is_nested_tensor_impl(other)) {
@@ -130,34 +184,35 @@ Tensor& NestedTensor_pow_out_3(Tensor& result, Scalar base, const Tensor& exp) {
   return result;
 }
 
-#define BINARY_OP(NAME)                                                        \
-  m.impl_UNBOXED(#NAME ".Tensor", NestedTensor_binary<at::NAME>);              \
-  m.impl_UNBOXED(#NAME "_.Tensor", NestedTensor_binary_<at::native::NAME##_>); \
-  m.impl_UNBOXED(#NAME ".out", NestedTensor_binary_out<at::NAME##_out>);
+#define BINARY_OP(NAME)                                                     \
+  NESTED_TENSOR_IMPL(                                                       \
+      #NAME ".Tensor", NestedTensor_binary_packed<at::NAME, at::NAME##_out>); \
+  NESTED_TENSOR_IMPL(#NAME "_.Tensor", NestedTensor_binary_<at::native::NAME##_>); \
+  NESTED_TENSOR_IMPL(#NAME ".out", NestedTensor_binary_out<at::NAME##_out>);
 
 TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
   BINARY_OP(div)
   BINARY_OP(mul)
   BINARY_OP(remainder)
 
-  m.impl_UNBOXED("add.Tensor", NestedTensor_binary<Scalar, at::add>);
+  NESTED_TENSOR_IMPL("add.Tensor", NestedTensor_binary<Scalar, at::add>);
 
-  m.impl_UNBOXED("eq.Tensor", NestedTensor_binary<at::eq>);
-  m.impl_UNBOXED("ne.Tensor", NestedTensor_binary<at::ne>);
+  NESTED_TENSOR_IMPL("eq.Tensor", NestedTensor_binary<at::eq>);
+  NESTED_TENSOR_IMPL("ne.Tensor", NestedTensor_binary<at::ne>);
 
-  m.impl_UNBOXED("atan2", NestedTensor_binary<at::atan2>);
-  m.impl_UNBOXED("atan2_", NestedTensor_binary_<at::native::atan2_>);
-  m.impl_UNBOXED("atan2.out", NestedTensor_binary_out<at::atan2_out>);
+  NESTED_TENSOR_IMPL("atan2", NestedTensor_binary<at::atan2>);
+  NESTED_TENSOR_IMPL("atan2_", NestedTensor_binary_<at::native::atan2_>);
+  NESTED_TENSOR_IMPL("atan2.out", NestedTensor_binary_out<at::atan2_out>);
 
-  m.impl_UNBOXED("sub.Tensor", NestedTensor_binary<Scalar, at::sub>);
-  m.impl_UNBOXED("sub_.Tensor", NestedTensor_sub_);
-  m.impl_UNBOXED("sub.out", NestedTensor_sub_out);
+  NESTED_TENSOR_IMPL("sub.Tensor", NestedTensor_binary<Scalar, at::sub>);
+  NESTED_TENSOR_IMPL("sub_.Tensor", NestedTensor_sub_);
+  NESTED_TENSOR_IMPL("sub.out", NestedTensor_sub_out);
 
-  m.impl_UNBOXED("pow.Tensor_Tensor_out", NestedTensor_pow_out_1);
-  m.impl_UNBOXED("pow.Tensor_Tensor", NestedTensor_binary<at::pow>);
-  m.impl_UNBOXED("pow_.Tensor", NestedTensor_pow__1);
-  m.impl_UNBOXED("pow.Tensor_Scalar_out", NestedTensor_pow_out_2);
-  m.impl_UNBOXED("pow.Tensor_Scalar", NestedTensor_pow_2);
-  m.impl_UNBOXED("pow.Scalar_out", NestedTensor_pow_out_3);
+  NESTED_TENSOR_IMPL("pow.Tensor_Tensor_out", NestedTensor_pow_out_1);
+  NESTED_TENSOR_IMPL("pow.Tensor_Tensor", NestedTensor_binary<at::pow>);
+  NESTED_TENSOR_IMPL("pow_.Tensor", NestedTensor_pow__1);
+  NESTED_TENSOR_IMPL("pow.Tensor_Scalar_out", NestedTensor_pow_out_2);
+  NESTED_TENSOR_IMPL("pow.Tensor_Scalar", NestedTensor_pow_2);
+  NESTED_TENSOR_IMPL("pow.Scalar_out", NestedTensor_pow_out_3);
 }
 }
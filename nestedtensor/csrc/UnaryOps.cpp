@@ -1,5 +1,7 @@
 #include <ATen/core/op_registration/op_registration.h>
+#include <nestedtensor/csrc/arena.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/profiling.h>
 #include <torch/library.h>
 
 namespace at {
@@ -32,6 +34,30 @@ Tensor NestedTensor_unary(const Tensor& self) {
           get_nested_tensor_structure(self)));
 }
 
+// NOTE: Floating point unary ops preserve the dtype, which lets us carve
+// the result out of a single arena block and write into it via the out
+// variant instead of allocating every constiuent separately.
+template <class F, F func, class G, G func_out>
+Tensor NestedTensor_unary_packed(const Tensor& self) {
+  auto structure = get_nested_tensor_structure(self);
+  if (!at::isFloatingType(self.scalar_type()) ||
+      !arena_eligible(structure)) {
+    NestedTensorOpScope::record_fallback();
+    return NestedTensor_unary<F, func>(self);
+  }
+  NestedTensor result = arena_empty_like(structure);
+  if (is_packed(self)) {
+    at::Tensor result_buffer = *result.get_buffer();
+    func_out(result_buffer, *get_nested_tensor(self).get_buffer());
+    return wrap_nested_tensor(std::move(result));
+  }
+  apply(
+      [](at::Tensor& result, at::Tensor& tensor) { func_out(result, tensor); },
+      result.get_structure(),
+      structure);
+  return wrap_nested_tensor(std::move(result));
+}
+
 template <class F, F func>
 Tensor& NestedTensor_unary_out(Tensor& result, const Tensor& self) {
   apply(
@@ -126,25 +152,37 @@ Tensor NestedTensor_mvlgamma(const Tensor& self, int64_t p) {
           get_nested_tensor_structure(self)));
 }
 
-#define UNARY_OP_INPLACE_METHOD(NAME)                                                      \
-  m.impl_UNBOXED(#NAME, NestedTensor_unary<decltype(&at::NAME), at::NAME>); \
-  m.impl_UNBOXED(                                                           \
+#define UNARY_OP_INPLACE_METHOD(NAME)                                       \
+  NESTED_TENSOR_IMPL(                                                       \
+      #NAME,                                                                \
+      NestedTensor_unary_packed<                                            \
+          decltype(&at::NAME),                                              \
+          at::NAME,                                                         \
+          decltype(&at::NAME##_out),                                        \
+          at::NAME##_out>);                                                 \
+  NESTED_TENSOR_IMPL(                                                       \
       #NAME "_", NestedTensor_unary_method_<decltype(&at::Tensor::NAME##_), &at::Tensor::NAME##_>); \
-  m.impl_UNBOXED(                                                           \
+  NESTED_TENSOR_IMPL(                                                       \
       #NAME ".out",                                                         \
       NestedTensor_unary_out<decltype(&at::NAME##_out), at::NAME##_out>);
 
-#define UNARY_OP(NAME) \
-  m.impl_UNBOXED(#NAME, NestedTensor_unary<decltype(&at::NAME), at::NAME>); \
-  m.impl_UNBOXED(                                                           \
+#define UNARY_OP(NAME)                                                      \
+  NESTED_TENSOR_IMPL(                                                       \
+      #NAME,                                                                \
+      NestedTensor_unary_packed<                                            \
+          decltype(&at::NAME),                                              \
+          at::NAME,                                                         \
+          decltype(&at::NAME##_out),                                        \
+          at::NAME##_out>);                                                 \
+  NESTED_TENSOR_IMPL(                                                       \
       #NAME "_", NestedTensor_unary_<decltype(&at::NAME##_), at::NAME##_>); \
-  m.impl_UNBOXED(                                                           \
+  NESTED_TENSOR_IMPL(                                                       \
       #NAME ".out",                                                         \
       NestedTensor_unary_out<decltype(&at::NAME##_out), at::NAME##_out>);
 
 #define UNARY_OP_NO_OUT(NAME)                                               \
-  m.impl_UNBOXED(#NAME, NestedTensor_unary<decltype(&at::NAME), at::NAME>); \
-  m.impl_UNBOXED(                                                           \
+  NESTED_TENSOR_IMPL(#NAME, NestedTensor_unary<decltype(&at::NAME), at::NAME>); \
+  NESTED_TENSOR_IMPL(                                                       \
       #NAME "_", NestedTensor_unary_<decltype(&at::NAME##_), at::NAME##_>);
 
 TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
@@ -186,20 +224,20 @@ TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
 
 
   // NOTE: mvlgamma doesn't have an out variant? why?
-  m.impl_UNBOXED("mvlgamma", NestedTensor_mvlgamma);
-  m.impl_UNBOXED("mvlgamma_", NestedTensor_mvlgamma_);
+  NESTED_TENSOR_IMPL("mvlgamma", NestedTensor_mvlgamma);
+  NESTED_TENSOR_IMPL("mvlgamma_", NestedTensor_mvlgamma_);
 
-  m.impl_UNBOXED("clamp", NestedTensor_clamp);
-  m.impl_UNBOXED("clamp_", NestedTensor_clamp_);
-  m.impl_UNBOXED("clamp.out", NestedTensor_clamp_out);
+  NESTED_TENSOR_IMPL("clamp", NestedTensor_clamp);
+  NESTED_TENSOR_IMPL("clamp_", NestedTensor_clamp_);
+  NESTED_TENSOR_IMPL("clamp.out", NestedTensor_clamp_out);
 
-  m.impl_UNBOXED("clamp_min", NestedTensor_clamp_min);
-  m.impl_UNBOXED("clamp_min_", NestedTensor_clamp_min_);
-  m.impl_UNBOXED("clamp_min.out", NestedTensor_clamp_min_out);
+  NESTED_TENSOR_IMPL("clamp_min", NestedTensor_clamp_min);
+  NESTED_TENSOR_IMPL("clamp_min_", NestedTensor_clamp_min_);
+  NESTED_TENSOR_IMPL("clamp_min.out", NestedTensor_clamp_min_out);
 
-  m.impl_UNBOXED("clamp_max", NestedTensor_clamp_max);
-  m.impl_UNBOXED("clamp_max_", NestedTensor_clamp_max_);
-  m.impl_UNBOXED("clamp_max.out", NestedTensor_clamp_max_out);
+  NESTED_TENSOR_IMPL("clamp_max", NestedTensor_clamp_max);
+  NESTED_TENSOR_IMPL("clamp_max_", NestedTensor_clamp_max_);
+  NESTED_TENSOR_IMPL("clamp_max.out", NestedTensor_clamp_max_out);
 
 }
 
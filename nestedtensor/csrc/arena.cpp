@@ -0,0 +1,173 @@
+#include <c10/core/CPUAllocator.h>
+#include <nestedtensor/csrc/arena.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+// Smallest block handed out by the pool.
+constexpr size_t kMinBlockBytes = 512;
+// Upper bound on the idle memory held by the pool. Blocks released while
+// the pool is full are returned to the system right away.
+constexpr size_t kMaxCachedBytes = size_t(1) << 30;
+
+size_t _round_size(size_t bytes) {
+  size_t result = kMinBlockBytes;
+  while (result < bytes) {
+    result <<= 1;
+  }
+  return result;
+}
+
+struct ArenaPool {
+  void* allocate(size_t bytes) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      auto it = _free_blocks.find(bytes);
+      if (it != _free_blocks.end() && it->second.size() > 0) {
+        void* ptr = it->second.back();
+        it->second.pop_back();
+        _cached_bytes -= bytes;
+        bytes_reused += bytes;
+        blocks_reused++;
+        return ptr;
+      }
+    }
+    bytes_reserved += bytes;
+    blocks_reserved++;
+    return c10::alloc_cpu(bytes);
+  }
+
+  void release(void* ptr, size_t bytes) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      if (_cached_bytes + bytes <= kMaxCachedBytes) {
+        _free_blocks[bytes].push_back(ptr);
+        _cached_bytes += bytes;
+        return;
+      }
+    }
+    c10::free_cpu(ptr);
+  }
+
+  void empty_cache() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (auto& size_class : _free_blocks) {
+      for (void* ptr : size_class.second) {
+        c10::free_cpu(ptr);
+      }
+    }
+    _free_blocks.clear();
+    _cached_bytes = 0;
+  }
+
+  int64_t cached_bytes() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _cached_bytes;
+  }
+
+  std::atomic<int64_t> bytes_reserved{0};
+  std::atomic<int64_t> blocks_reserved{0};
+  std::atomic<int64_t> bytes_reused{0};
+  std::atomic<int64_t> blocks_reused{0};
+
+ private:
+  std::mutex _mutex;
+  std::unordered_map<size_t, std::vector<void*>> _free_blocks;
+  size_t _cached_bytes = 0;
+};
+
+// NOTE: Intentionally leaked. Tensors backed by the pool may outlive static
+// destruction and still need to hand their block back.
+ArenaPool& _pool() {
+  static ArenaPool* pool = new ArenaPool();
+  return *pool;
+}
+
+} // namespace
+
+ArenaStats arena_stats() {
+  ArenaStats stats;
+  stats.bytes_reserved = _pool().bytes_reserved;
+  stats.blocks_reserved = _pool().blocks_reserved;
+  stats.bytes_reused = _pool().bytes_reused;
+  stats.blocks_reused = _pool().blocks_reused;
+  stats.bytes_cached = _pool().cached_bytes();
+  return stats;
+}
+
+void arena_reset_stats() {
+  _pool().bytes_reserved = 0;
+  _pool().blocks_reserved = 0;
+  _pool().bytes_reused = 0;
+  _pool().blocks_reused = 0;
+}
+
+void arena_empty_cache() {
+  _pool().empty_cache();
+}
+
+at::Tensor arena_empty(int64_t numel, const at::TensorOptions& options_) {
+  auto options =
+      at::TensorOptions().dtype(options_.dtype()).device(options_.device());
+  if (!options.device().is_cpu()) {
+    return at::empty({numel}, options);
+  }
+  size_t bytes = _round_size(numel * options.dtype().itemsize());
+  void* ptr = _pool().allocate(bytes);
+  return at::from_blob(
+      ptr,
+      {numel},
+      [bytes](void* data) { _pool().release(data, bytes); },
+      options);
+}
+
+size_t arena_block_bytes(int64_t numel, const at::TensorOptions& options) {
+  size_t bytes = numel * options.dtype().itemsize();
+  return options.device().is_cpu() ? _round_size(bytes) : bytes;
+}
+
+bool arena_eligible(const TensorNode& structure) {
+  if (!at::GradMode::is_enabled()) {
+    return true;
+  }
+  auto fn = [](at::Tensor leaf, bool input) {
+    return input && !leaf.requires_grad();
+  };
+  return reduce<decltype(fn), bool, at::Tensor>(structure, fn, true);
+}
+
+NestedTensor arena_empty_like(
+    const TensorNode& structure,
+    const at::TensorOptions& options) {
+  auto fn = [](at::Tensor leaf, int64_t input) {
+    return input + leaf.numel();
+  };
+  int64_t numel = reduce<decltype(fn), int64_t, at::Tensor>(structure, fn, 0);
+  at::Tensor buffer = arena_empty(numel, options);
+  int64_t offset = 0;
+  TensorNode result = map(
+      [&buffer, &offset](at::Tensor leaf) {
+        at::Tensor view =
+            buffer.narrow(0, offset, leaf.numel()).view(leaf.sizes());
+        offset += leaf.numel();
+        return view;
+      },
+      structure);
+  return NestedTensor(std::move(buffer), std::move(result));
+}
+
+NestedTensor arena_empty_like(const TensorNode& structure) {
+  if (auto first = get_first_leaf(structure)) {
+    return arena_empty_like(structure, first->options());
+  }
+  return arena_empty_like(structure, at::TensorOptions());
+}
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,50 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// The arena reserves a single block of memory per NestedTensor result and
+// carves the constiuents out of it instead of allocating each one on its own.
+// Blocks are bucketed into power-of-two size classes and, once the last view
+// into a block dies, returned to a pool for reuse by later results.
+//
+// NOTE: Only CPU memory is pooled. Other devices already come with a caching
+// allocator, so for them we fall back to a single at::empty per result.
+
+struct ArenaStats {
+  // Bytes and blocks freshly allocated from the system.
+  int64_t bytes_reserved;
+  int64_t blocks_reserved;
+  // Bytes and blocks served from the pool instead.
+  int64_t bytes_reused;
+  int64_t blocks_reused;
+  // Bytes currently sitting in the pool waiting to be reused.
+  int64_t bytes_cached;
+};
+
+ArenaStats arena_stats();
+void arena_reset_stats();
+// Releases all idle blocks back to the system.
+void arena_empty_cache();
+
+// A flat, uninitialized Tensor of numel elements backed by an arena block.
+at::Tensor arena_empty(int64_t numel, const at::TensorOptions& options);
+// Bytes of memory that arena_empty holds on to for a Tensor of numel
+// elements, i.e. including the rounding up to the block's size class.
+size_t arena_block_bytes(int64_t numel, const at::TensorOptions& options);
+
+// Whether results shaped like structure may be carved out of the arena.
+// Constiuents that take part in autograd keep their own allocations, because
+// writing them into shared memory would tie their graphs together.
+bool arena_eligible(const TensorNode& structure);
+
+// Allocates a single block for constiuents of the same sizes as those of
+// structure and returns a NestedTensor of contiguous views into it.
+NestedTensor arena_empty_like(
+    const TensorNode& structure,
+    const at::TensorOptions& options);
+NestedTensor arena_empty_like(const TensorNode& structure);
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,226 @@
+#include <nestedtensor/csrc/batching.h>
+
+namespace torch {
+namespace nested_tensor {
+
+c10::optional<at::Tensor> BatchedRequest::wait(
+    c10::optional<double> timeout_ms) const {
+  if (timeout_ms &&
+      _result.wait_for(std::chrono::duration<double, std::milli>(
+          *timeout_ms)) != std::future_status::ready) {
+    return c10::nullopt;
+  }
+  return _result.get();
+}
+
+DynamicBatch::~DynamicBatch() {
+  if (!_finished) {
+    fail("DynamicBatch was destroyed before it was completed.");
+  }
+}
+
+void DynamicBatch::complete(const at::Tensor& result) {
+  TORCH_CHECK(!_finished, "DynamicBatch was already completed.");
+  std::vector<at::Tensor> entries;
+  if (is_nested_tensor_impl(result)) {
+    for (TensorNode child : get_nested_tensor_structure(result).unbind()) {
+      entries.push_back(
+          child.is_leaf() ? child.payload()
+                          : wrap_tensor_node(std::move(child)));
+    }
+  } else {
+    TORCH_CHECK(result.dim() > 0, "Cannot scatter a 0-dim result.");
+    entries = result.unbind(0);
+  }
+  TORCH_CHECK(
+      entries.size() == _results.size(),
+      "Expected a result with one entry per request, i.e. ",
+      _results.size(),
+      " entries along dimension 0, but got ",
+      entries.size(),
+      ".");
+  _finished = true;
+  for (size_t i = 0; i < entries.size(); i++) {
+    _results[i].set_value(entries[i]);
+  }
+}
+
+void DynamicBatch::fail(const std::string& message) {
+  TORCH_CHECK(!_finished, "DynamicBatch was already completed.");
+  _finished = true;
+  for (auto& result : _results) {
+    result.set_exception(std::make_exception_ptr(std::runtime_error(message)));
+  }
+}
+
+DynamicBatcher::DynamicBatcher(
+    int64_t max_tokens,
+    double max_latency_ms,
+    c10::optional<int64_t> max_batch_size)
+    : _max_tokens(max_tokens),
+      _max_latency(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double, std::milli>(max_latency_ms))),
+      _max_batch_size(max_batch_size),
+      _size(0),
+      _closed(false),
+      _waiting(false),
+      _batch_tokens(0) {
+  TORCH_CHECK(max_tokens > 0, "max_tokens needs to be positive.");
+  TORCH_CHECK(max_latency_ms >= 0, "max_latency_ms can't be negative.");
+  TORCH_CHECK(
+      !max_batch_size || *max_batch_size > 0,
+      "max_batch_size needs to be positive.");
+}
+
+DynamicBatcher::~DynamicBatcher() {
+  _fail_pending(
+      "DynamicBatcher was destroyed before the request was handed out.");
+}
+
+// NOTE: The consumer sets _waiting before it checks _size for the last time
+// and producers increment _size before they check _waiting, so at least one
+// of them sees the other's write. Taking the lock to notify makes sure the
+// consumer is already waiting on _wake.
+void DynamicBatcher::_notify() {
+  if (_waiting.load()) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _wake.notify_one();
+  }
+}
+
+// NOTE: Producers increment _size before they check _closed and the
+// consumer only flushes once it sees _closed and a _size of 0. So either a
+// producer sees _closed and backs out or the consumer keeps draining until
+// its request was pushed, and _size never drops below the queue's length.
+BatchedRequest DynamicBatcher::submit(at::Tensor tensor) {
+  TORCH_CHECK(
+      !is_nested_tensor_impl(tensor),
+      "DynamicBatcher only accepts Tensor requests.");
+  _size++;
+  if (_closed.load()) {
+    _size--;
+    _notify();
+    TORCH_CHECK(false, "Cannot submit requests to a closed DynamicBatcher.");
+  }
+  Request request;
+  request.tensor = tensor.detach();
+  request.arrival = Clock::now();
+  BatchedRequest result(request.result.get_future().share());
+  _queue.push(std::move(request));
+  _notify();
+  return result;
+}
+
+void DynamicBatcher::close() {
+  _closed.store(true);
+  std::lock_guard<std::mutex> guard(_mutex);
+  _wake.notify_one();
+}
+
+void DynamicBatcher::_fail_pending(const std::string& message) {
+  auto fail = [&message](std::promise<at::Tensor>& result) {
+    result.set_exception(std::make_exception_ptr(std::runtime_error(message)));
+  };
+  for (auto& result : _results) {
+    fail(result);
+  }
+  _results.clear();
+  if (_carry) {
+    fail(_carry->result);
+    _carry = c10::nullopt;
+  }
+  while (auto request = _queue.pop()) {
+    _size--;
+    fail(request->result);
+  }
+}
+
+void DynamicBatcher::_add(Request request) {
+  int64_t tokens = _tokens(request.tensor);
+  if (_results.size() > 0 && _batch_tokens + tokens > _max_tokens) {
+    _carry = std::move(request);
+    return;
+  }
+  try {
+    _builder.append(request.tensor);
+  } catch (...) {
+    // The request doesn't match the others, e.g. in dtype or dimension.
+    request.result.set_exception(std::current_exception());
+    return;
+  }
+  if (_results.size() == 0) {
+    _batch_tokens = 0;
+    _deadline = request.arrival + _max_latency;
+  }
+  _batch_tokens += tokens;
+  _results.push_back(std::move(request.result));
+}
+
+bool DynamicBatcher::_full() const {
+  return _carry || _batch_tokens >= _max_tokens ||
+      (_max_batch_size && int64_t(_results.size()) >= *_max_batch_size);
+}
+
+std::shared_ptr<DynamicBatch> DynamicBatcher::_finish() {
+  auto batch =
+      std::make_shared<DynamicBatch>(_builder.finish(), std::move(_results));
+  _results.clear();
+  _batch_tokens = 0;
+  return batch;
+}
+
+std::shared_ptr<DynamicBatch> DynamicBatcher::next_batch(
+    c10::optional<double> timeout_ms) {
+  c10::optional<Clock::time_point> until;
+  if (timeout_ms) {
+    until = Clock::now() +
+        std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(*timeout_ms));
+  }
+  while (true) {
+    if (_carry && _results.size() == 0) {
+      Request request = std::move(*_carry);
+      _carry = c10::nullopt;
+      _add(std::move(request));
+    }
+    while (_results.size() == 0 || !_full()) {
+      auto request = _queue.pop();
+      if (!request) {
+        break;
+      }
+      _size--;
+      _add(std::move(*request));
+    }
+    bool flush = _closed.load() && _size.load() == 0;
+    if (_results.size() > 0 &&
+        (_full() || flush || Clock::now() >= _deadline)) {
+      return _finish();
+    }
+    if (_results.size() == 0 && flush) {
+      // Nothing may be left at this point, but don't strand anything that
+      // is once the consumer stops.
+      _fail_pending(
+          "DynamicBatcher was closed before the request was handed out.");
+      return nullptr;
+    }
+    if (until && Clock::now() >= *until) {
+      return nullptr;
+    }
+    c10::optional<Clock::time_point> wake = until;
+    if (_results.size() > 0 && (!wake || _deadline < *wake)) {
+      wake = _deadline;
+    }
+    auto ready = [this]() { return _size.load() > 0 || _closed.load(); };
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waiting.store(true);
+    if (wake) {
+      _wake.wait_until(lock, *wake, ready);
+    } else {
+      _wake.wait(lock, ready);
+    }
+    _waiting.store(false);
+  }
+}
+
+} // namespace nested_tensor
+} // namespace torch
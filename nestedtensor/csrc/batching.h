@@ -0,0 +1,207 @@
+#pragma once
+#include <nestedtensor/csrc/creation.h>
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
+namespace torch {
+namespace nested_tensor {
+
+// Unbounded multi-producer single-consumer queue after Dmitry Vyukov's
+// intrusive node-based design. push never blocks or locks. pop must only be
+// called from a single thread at a time and may spuriously come up empty
+// while a producer is in the middle of a push.
+template <class T>
+struct MPSCQueue {
+  MPSCQueue() : _head(&_stub), _tail(&_stub) {}
+  ~MPSCQueue() {
+    while (pop()) {
+    }
+  }
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  void push(T value) {
+    _push(new Node(std::move(value)));
+  }
+  c10::optional<T> pop() {
+    Node* tail = _tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &_stub) {
+      if (!next) {
+        return c10::nullopt;
+      }
+      _tail = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (!next) {
+      if (tail != _head.load(std::memory_order_acquire)) {
+        // A producer swapped in a new head but didn't link it yet.
+        return c10::nullopt;
+      }
+      _push(&_stub);
+      next = tail->next.load(std::memory_order_acquire);
+      if (!next) {
+        return c10::nullopt;
+      }
+    }
+    _tail = next;
+    c10::optional<T> value(std::move(tail->value));
+    delete tail;
+    return value;
+  }
+
+ private:
+  struct Node {
+    Node() : next(nullptr) {}
+    explicit Node(T value) : value(std::move(value)), next(nullptr) {}
+    T value;
+    std::atomic<Node*> next;
+  };
+  void _push(Node* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  std::atomic<Node*> _head;
+  // Only touched by the consumer.
+  Node* _tail;
+  Node _stub;
+};
+
+// Handle to the result of a request submitted to a DynamicBatcher.
+struct BatchedRequest {
+  explicit BatchedRequest(std::shared_future<at::Tensor> result)
+      : _result(std::move(result)) {}
+  bool done() const {
+    return _result.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready;
+  }
+  // Blocks until the batch of this request was completed and returns the
+  // part of the result that belongs to it. Rethrows the error if the batch
+  // failed. Returns nullopt if timeout_ms passed first.
+  c10::optional<at::Tensor> wait(c10::optional<double> timeout_ms) const;
+
+ private:
+  std::shared_future<at::Tensor> _result;
+};
+
+// A batch handed out by DynamicBatcher::next_batch. Exactly one of complete
+// or fail must be called once the batch has been processed. If neither is,
+// the requests fail when the batch is destroyed.
+struct DynamicBatch {
+  DynamicBatch(at::Tensor input, std::vector<std::promise<at::Tensor>> results)
+      : _input(std::move(input)), _results(std::move(results)) {}
+  ~DynamicBatch();
+  DynamicBatch(const DynamicBatch&) = delete;
+  DynamicBatch& operator=(const DynamicBatch&) = delete;
+  // Packed NestedTensor of nested_dim 1 with one constiuent per request in
+  // the order they arrived.
+  const at::Tensor& input() const {
+    return _input;
+  }
+  int64_t size() const {
+    return _results.size();
+  }
+  // Scatters the entries of result along dimension 0 back to the requests.
+  // result is either a NestedTensor or a Tensor with one entry per request.
+  void complete(const at::Tensor& result);
+  void fail(const std::string& message);
+
+ private:
+  at::Tensor _input;
+  std::vector<std::promise<at::Tensor>> _results;
+  bool _finished = false;
+};
+
+// Collects variable-length requests from any number of threads and groups
+// them into packed NestedTensors for a single consumer thread. A batch is
+// handed out as soon as
+//
+//   - it holds max_tokens tokens, i.e. entries along dimension 0 of the
+//     requests, or the next request wouldn't fit anymore, or
+//   - it holds max_batch_size requests, or
+//   - its oldest request has waited for max_latency_ms.
+//
+// Requests are copied into the batch's buffer as the consumer picks them up
+// off the queue, so forming the batch doesn't need another pass over the
+// data. A single request of more than max_tokens tokens forms its own batch.
+struct DynamicBatcher {
+  DynamicBatcher(
+      int64_t max_tokens,
+      double max_latency_ms,
+      c10::optional<int64_t> max_batch_size);
+  // Fails the requests that weren't handed out yet.
+  ~DynamicBatcher();
+  DynamicBatcher(const DynamicBatcher&) = delete;
+  DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+  // Thread-safe and lock-free unless the consumer is asleep.
+  BatchedRequest submit(at::Tensor tensor);
+  // Only to be called by a single consumer thread at a time. Blocks until
+  // the next batch is due or timeout_ms passed, in which case it returns
+  // nullptr. Without a timeout it waits until close() and returns nullptr
+  // once all requests have been handed out.
+  std::shared_ptr<DynamicBatch> next_batch(c10::optional<double> timeout_ms);
+  // Rejects further requests and flushes the pending ones without waiting
+  // for their deadline.
+  void close();
+  bool closed() const {
+    return _closed.load();
+  }
+  // Number of submitted requests not yet picked up by the consumer,
+  // including those still in the middle of submit.
+  int64_t pending() const {
+    return _size.load();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Request {
+    at::Tensor tensor;
+    std::promise<at::Tensor> result;
+    Clock::time_point arrival;
+  };
+
+  // Copies request into the current batch, or keeps it as _carry if it
+  // exceeds the token budget. Fails it if it doesn't match the constiuents
+  // already in there.
+  void _add(Request request);
+  int64_t _tokens(const at::Tensor& tensor) const {
+    return tensor.dim() > 0 ? tensor.size(0) : 1;
+  }
+  bool _full() const;
+  // Fails the current batch, _carry and whatever is left in the queue.
+  void _fail_pending(const std::string& message);
+  std::shared_ptr<DynamicBatch> _finish();
+  void _notify();
+
+  const int64_t _max_tokens;
+  const Clock::duration _max_latency;
+  const c10::optional<int64_t> _max_batch_size;
+
+  MPSCQueue<Request> _queue;
+  std::atomic<int64_t> _size;
+  std::atomic<bool> _closed;
+  // Lets producers wake up the consumer. They only take the lock if it
+  // announced that it's going to sleep.
+  std::atomic<bool> _waiting;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+
+  // Consumer state: the batch currently being filled.
+  NestedTensorBuilder _builder;
+  std::vector<std::promise<at::Tensor>> _results;
+  int64_t _batch_tokens;
+  Clock::time_point _deadline;
+  // The request that didn't fit into the current batch and opens the next.
+  c10::optional<Request> _carry;
+};
+
+} // namespace nested_tensor
+} // namespace torch
@@ -1,3 +1,4 @@
+#include <nestedtensor/csrc/arena.h>
 #include <nestedtensor/csrc/creation.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
 #include <nestedtensor/csrc/py_utils.h>
@@ -5,6 +6,7 @@
 #include <torch/csrc/jit/python/pybind_utils.h>
 #include <torch/extension.h>
 #include <torch/csrc/jit/python/pybind_utils.h>
+#include <numeric>
 
 namespace py = pybind11;
 
@@ -157,7 +159,7 @@ bool _verify_variables(
 bool _verify_variables(
     const at::Tensor& first_variable,
     const TensorNode& nested_node,
-    bool throw_error = false) {
+    bool throw_error) {
   const int64_t dim = first_variable.dim();
   const at::Layout& layout = first_variable.layout();
   const at::Device& device = first_variable.device();
@@ -202,18 +204,96 @@ NestedTensor _as_nested_tensor(py::sequence list) {
       all_same,
       "Input nested list entries need to consist entirely of Tensors or NestedTensors.");
   TensorNode structure =
-      map([](c10::IValue a) { return a.toTensor().clone().detach(); }, ivalue_structure);
+      map([](c10::IValue a) { return a.toTensor().detach(); }, ivalue_structure);
   if (auto first = get_first_leaf(structure)) {
     if (!_verify_variables(*first, structure)) {
       _verify_variables(*first, structure, true);
     }
   }
-  return NestedTensor(std::move(structure));
+  // Copy all constiuents into a single block instead of cloning each. Unlike
+  // clone, this doesn't preserve strides, i.e. the constiuents are always
+  // contiguous.
+  NestedTensor result = arena_empty_like(structure);
+  apply(
+      [](at::Tensor& result, at::Tensor& tensor) { result.copy_(tensor); },
+      result.get_structure(),
+      structure);
+  return result;
 }
 
 at::Tensor nested_tensor_impl(py::sequence list) {
   return at::detail::make_tensor<NestedTensorImpl>(_as_nested_tensor(list)).contiguous();
 }
 
+void NestedTensorBuilder::reserve(int64_t numel) {
+  TORCH_CHECK(
+      _first,
+      "Cannot reserve memory before the first constiuent determines the dtype and device.");
+  if (_buffer && _buffer->numel() >= numel) {
+    return;
+  }
+  at::NoGradGuard no_grad;
+  at::Tensor buffer = arena_empty(numel, _first->options());
+  if (_buffer) {
+    buffer.narrow(0, 0, _numel).copy_(_buffer->narrow(0, 0, _numel));
+  }
+  _buffer = buffer;
+}
+
+void NestedTensorBuilder::append(const at::Tensor& tensor_) {
+  TORCH_CHECK(
+      !is_nested_tensor_impl(tensor_),
+      "NestedTensorBuilder only accepts Tensor constiuents.");
+  at::Tensor tensor = tensor_.detach();
+  if (!_first) {
+    _first = tensor;
+  }
+  _verify_variables(*_first, TensorNode(at::Tensor(tensor)), true);
+  int64_t numel = tensor.numel();
+  if (!_buffer || _buffer->numel() < _numel + numel) {
+    // Grow geometrically to amortize the cost of moving the data.
+    int64_t capacity = _buffer ? _buffer->numel() : 0;
+    reserve(std::max(_numel + numel, 2 * capacity));
+  }
+  at::NoGradGuard no_grad;
+  _buffer->narrow(0, _numel, numel).view(tensor.sizes()).copy_(tensor);
+  _sizes.push_back(tensor.sizes().vec());
+  _numel += numel;
+}
+
+at::Tensor NestedTensorBuilder::finish() {
+  std::vector<TensorNode> children;
+  if (!_buffer) {
+    _sizes.clear();
+    return at::wrap_tensor_node(TensorNode(std::move(children)));
+  }
+  at::Tensor buffer = _buffer->narrow(0, 0, _numel);
+  if (arena_block_bytes(_numel, buffer.options()) <
+      arena_block_bytes(_buffer->numel(), buffer.options())) {
+    // Otherwise the result keeps all of the geometrically grown block
+    // alive. Copy into one that fits if that is of a smaller size class,
+    // i.e. at most half as big.
+    at::NoGradGuard no_grad;
+    at::Tensor exact = arena_empty(_numel, buffer.options());
+    exact.copy_(buffer);
+    buffer = exact;
+  }
+  int64_t offset = 0;
+  for (const auto& size : _sizes) {
+    int64_t numel = std::accumulate(
+        size.begin(), size.end(), int64_t(1), std::multiplies<int64_t>());
+    children.emplace_back(
+        TensorNode(buffer.narrow(0, offset, numel).view(size)));
+    offset += numel;
+  }
+  // The result owns the data from here on. Start over with fresh memory.
+  _buffer = c10::nullopt;
+  _first = c10::nullopt;
+  _sizes.clear();
+  _numel = 0;
+  return at::wrap_nested_tensor(
+      NestedTensor(std::move(buffer), TensorNode(std::move(children))));
+}
+
 } // namespace nested_tensor
 } // namespace torch
@@ -9,5 +9,36 @@ NestedNode<py::object> py_to_nested_node(py::object&& py_obj);
 
 at::Tensor nested_tensor_impl(pybind11::sequence list);
 
+// Checks whether nested_node may form a NestedTensor together with
+// constiuents like first_variable.
+bool _verify_variables(
+    const at::Tensor& first_variable,
+    const TensorNode& nested_node,
+    bool throw_error = false);
+
+// Builds a NestedTensor from constiuents that arrive one at a time. They are
+// copied into a single buffer as they come in, which grows geometrically,
+// and finish() returns views into it without copying again.
+struct NestedTensorBuilder {
+  NestedTensorBuilder() : _numel(0) {}
+  // Makes room for a total of numel elements.
+  void reserve(int64_t numel);
+  void append(const at::Tensor& tensor);
+  int64_t len() const {
+    return _sizes.size();
+  }
+  // Returns the NestedTensor of all constiuents appended so far and resets
+  // the builder. The constiuents are views into the builder's buffer,
+  // unless a smaller block would do, in which case they're copied into one
+  // once more.
+  at::Tensor finish();
+
+ private:
+  c10::optional<at::Tensor> _first;
+  c10::optional<at::Tensor> _buffer;
+  std::vector<std::vector<int64_t>> _sizes;
+  int64_t _numel;
+};
+
 } // namespace nested_tensor
 } // namespace torch
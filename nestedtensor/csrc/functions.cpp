@@ -1,20 +1,261 @@
+#include <ATen/AccumulateType.h>
+#include <ATen/CPUGeneratorImpl.h>
+#include <ATen/Dispatch.h>
+#include <ATen/InferSize.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/PhiloxRNGEngine.h>
+#include <nestedtensor/csrc/arena.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/profiling.h>
 #include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <torch/csrc/autograd/custom_function.h>
 #include <torch/extension.h>
 #include <torch/library.h>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <numeric>
 
 using namespace torch::nn;
 namespace F = torch::nn::functional;
 
 namespace at {
 
+// Half and bfloat16 constiuents are kept as is to save memory bandwidth,
+// but reductions over them accumulate in float and only round the result.
+c10::optional<ScalarType> _accumulate_type(ScalarType dtype) {
+  if (dtype == kHalf || dtype == kBFloat16) {
+    return kFloat;
+  }
+  return c10::nullopt;
+}
+
+// Type to convert t to before calling ATen's softmax or layer_norm, if any.
+// On CUDA these kernels already accumulate half and bfloat16 in float and
+// only round the result, so the constiuents are passed as is. ATen has no
+// reduced precision CPU kernels for them, so there the constiuents are
+// converted to float and back, which costs a float copy of the input and
+// the output.
+c10::optional<ScalarType> _upcast_type(const Tensor& t) {
+  if (t.is_cuda()) {
+    return c10::nullopt;
+  }
+  return _accumulate_type(t.scalar_type());
+}
+
+// NOTE: Dropout draws a single seed from the default generator per call and
+// derives whether to keep an element from Philox at the element's position
+// in the packed layout. The mask therefore neither depends on how the work
+// is split up nor on how the constiuents are stored, and can be recomputed
+// from the seed instead of being kept around for the backward pass.
+uint64_t _dropout_seed() {
+  auto gen = at::get_generator_or_default<at::CPUGeneratorImpl>(
+      c10::nullopt, at::detail::getDefaultCPUGenerator());
+  std::lock_guard<std::mutex> lock(gen->mutex_);
+  return gen->random64();
+}
+
+// Calls fn(i, keep) for i in [0, numel) with the decision for the element at
+// position offset + i. Each group of four consecutive positions shares one
+// Philox counter.
+template <class F>
+void _philox_dropout(
+    int64_t numel,
+    double p,
+    uint64_t seed,
+    int64_t offset,
+    const F& fn) {
+  // Draws of at least threshold keep their element.
+  uint64_t threshold = static_cast<uint64_t>(std::ceil(p * 4294967296.0));
+  at::parallel_for(
+      0, numel, at::internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        int64_t position = offset + begin;
+        at::Philox4_32_10 engine(seed, 0, position / 4);
+        for (int64_t i = 0; i < position % 4; i++) {
+          engine();
+        }
+        for (int64_t i = begin; i < end; i++) {
+          fn(i, uint64_t(engine()) >= threshold);
+        }
+      });
+}
+
+// output and input are contiguous and may be the same.
+void _dropout_kernel(
+    Tensor& output,
+    const Tensor& input,
+    double p,
+    uint64_t seed,
+    int64_t offset) {
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      kHalf, kBFloat16, input.scalar_type(), "NestedTensor_dropout", [&] {
+        using acc_t = at::acc_type<scalar_t, false>;
+        const scalar_t* input_data = input.data_ptr<scalar_t>();
+        scalar_t* output_data = output.data_ptr<scalar_t>();
+        acc_t scale = p < 1 ? acc_t(1) / acc_t(1 - p) : acc_t(0);
+        _philox_dropout(
+            input.numel(), p, seed, offset, [&](int64_t i, bool keep) {
+              output_data[i] = keep
+                  ? scalar_t(static_cast<acc_t>(input_data[i]) * scale)
+                  : scalar_t(0);
+            });
+      });
+}
+
+void _dropout_mask_kernel(
+    Tensor& output,
+    const Tensor& input,
+    double p,
+    uint64_t seed,
+    int64_t offset) {
+  bool* output_data = output.data_ptr<bool>();
+  _philox_dropout(
+      input.numel(), p, seed, offset, [output_data](int64_t i, bool keep) {
+        output_data[i] = keep;
+      });
+}
+
+// Whether dropout can run on the constiuents at once.
+bool _fused_dropout(const Tensor& input) {
+  return input.device().is_cpu() && at::isFloatingType(input.scalar_type());
+}
+
+// Dropout of the constiuents laid out back-to-back in a flat Tensor. The
+// backward pass recomputes the mask from the seed instead of saving it.
+struct FusedDropout : public torch::autograd::Function<FusedDropout> {
+  static Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      Tensor input,
+      double p,
+      int64_t seed) {
+    ctx->saved_data["p"] = p;
+    ctx->saved_data["seed"] = seed;
+    Tensor output = at::empty_like(input, MemoryFormat::Contiguous);
+    _dropout_kernel(output, input.contiguous(), p, seed, 0);
+    return output;
+  }
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs) {
+    double p = ctx->saved_data["p"].toDouble();
+    int64_t seed = ctx->saved_data["seed"].toInt();
+    Tensor grad = grad_outputs[0].contiguous();
+    Tensor grad_input = at::empty_like(grad);
+    _dropout_kernel(grad_input, grad, p, seed, 0);
+    return {grad_input, Tensor(), Tensor()};
+  }
+};
+
+// Runs kernel on result and input, either once on the buffers if input is
+// packed or per constiuent with its position in the packed layout.
+template <class F>
+void _dropout_apply(
+    Tensor& result,
+    const Tensor& input,
+    double p,
+    uint64_t seed,
+    F kernel) {
+  if (is_packed(input) && is_packed(result)) {
+    at::Tensor result_buffer = *get_nested_tensor(result).get_buffer();
+    kernel(result_buffer, *get_nested_tensor(input).get_buffer(), p, seed, 0);
+    return;
+  }
+  int64_t offset = 0;
+  apply(
+      [&](at::Tensor& result, at::Tensor& input) {
+        at::Tensor output = result.is_contiguous()
+            ? result
+            : at::empty_like(result, at::MemoryFormat::Contiguous);
+        kernel(output, input.contiguous(), p, seed, offset);
+        if (!output.is_same(result)) {
+          result.copy_(output);
+        }
+        offset += input.numel();
+      },
+      get_nested_tensor_structure(result),
+      get_nested_tensor_structure(input));
+}
+
+Tensor NestedTensor_dropout_with_seed(
+    const Tensor& input,
+    double p,
+    int64_t seed) {
+  TORCH_CHECK(
+      p >= 0 && p <= 1,
+      "dropout probability has to be between 0 and 1, but got ",
+      p);
+  TORCH_CHECK(
+      _fused_dropout(input),
+      "dropout_with_seed requires floating point CPU constiuents.");
+  TensorNode structure = get_nested_tensor_structure(input);
+  std::vector<at::Tensor> leaves = flatten(structure).vec();
+  if (leaves.size() > 0 && !arena_eligible(structure)) {
+    // The flat layout matches the packed one, so the mask is the same.
+    for (at::Tensor& leaf : leaves) {
+      leaf = leaf.reshape({-1});
+    }
+    Tensor flat = FusedDropout::apply(at::cat(leaves, 0), p, seed);
+    int64_t offset = 0;
+    return wrap_tensor_node(map(
+        [&flat, &offset](at::Tensor leaf) {
+          at::Tensor view =
+              flat.narrow(0, offset, leaf.numel()).view(leaf.sizes());
+          offset += leaf.numel();
+          return view;
+        },
+        structure));
+  }
+  Tensor result = wrap_nested_tensor(arena_empty_like(structure));
+  _dropout_apply(result, input, p, seed, _dropout_kernel);
+  return result;
+}
+
+Tensor NestedTensor_dropout_mask(const Tensor& input, double p, int64_t seed) {
+  TORCH_CHECK(
+      p >= 0 && p <= 1,
+      "dropout probability has to be between 0 and 1, but got ",
+      p);
+  TORCH_CHECK(input.device().is_cpu(), "dropout_mask requires CPU constiuents.");
+  Tensor result = wrap_nested_tensor(arena_empty_like(
+      get_nested_tensor_structure(input),
+      input.options().dtype(kBool)));
+  _dropout_apply(result, input, p, seed, _dropout_mask_kernel);
+  return result;
+}
+
+std::tuple<Tensor, int64_t> NestedTensor_fused_dropout(
+    const Tensor& input,
+    double p) {
+  int64_t seed = _dropout_seed();
+  return std::make_tuple(NestedTensor_dropout_with_seed(input, p, seed), seed);
+}
+
 Tensor NestedTensor_dropout(const Tensor& input, double p, bool train) {
+  if (train && p > 0 && _fused_dropout(input)) {
+    return NestedTensor_dropout_with_seed(input, p, _dropout_seed());
+  }
+  if (train) {
+    NestedTensorOpScope::record_fallback();
+  }
   return wrap_tensor_node(
       map([&](const at::Tensor t) { return at::dropout(t, p, train); },
           get_nested_tensor_structure(input)));
 }
 
 Tensor& NestedTensor_dropout_(Tensor& input, double p, bool train) {
+  if (train && p > 0 && _fused_dropout(input) &&
+      arena_eligible(get_nested_tensor_structure(input))) {
+    TORCH_CHECK(
+        p <= 1,
+        "dropout probability has to be between 0 and 1, but got ",
+        p);
+    _dropout_apply(input, input, p, _dropout_seed(), _dropout_kernel);
+    return input;
+  }
+  if (train) {
+    NestedTensorOpScope::record_fallback();
+  }
   apply(
       [&](at::Tensor t) { return at::dropout_(t, p, train); },
       get_nested_tensor_structure(input));
@@ -29,21 +270,174 @@ Tensor NestedTensor_conv2d(
     IntArrayRef padding,
     IntArrayRef dilation,
     int64_t groups) {
-  return wrap_tensor_node(map(
-      [&weight, &bias, &stride, &padding, &dilation, groups](at::Tensor t) {
-        return at::convolution(
-                   t.unsqueeze(0),
-                   weight,
-                   bias,
-                   stride,
-                   padding,
-                   dilation,
-                   false,
-                   {{0, 0}},
-                   groups)
-            .squeeze(0);
+  auto fn = [&weight, &bias, &stride, &padding, &dilation, groups](
+                at::Tensor t) {
+    return at::convolution(
+        t, weight, bias, stride, padding, dilation, false, {{0, 0}}, groups);
+  };
+  if (auto result = dense_batched_map(fn, input)) {
+    return *result;
+  }
+  return wrap_tensor_node(batched_map(fn, input));
+}
+
+// NOTE: Runs conv1d over constiuents of size [channels, length] as if they
+// were a single long sequence. Each constiuent is padded on its own and
+// starts at a multiple of stride, so that one conv1d call covers all of them
+// and the outputs that straddle two constiuents can simply be skipped. The
+// constiuents are copied into and out of the sequence through strided views,
+// so the cost in time and memory is proportional to the total length. All
+// steps are differentiable, so autograd provides backward.
+Tensor NestedTensor_conv1d_padded(
+    const Tensor& input,
+    const Tensor& weight,
+    const c10::optional<Tensor>& bias,
+    IntArrayRef stride_,
+    IntArrayRef padding_,
+    IntArrayRef dilation_,
+    int64_t groups,
+    const std::string& padding_mode) {
+  TORCH_CHECK(
+      padding_mode == "zeros" || padding_mode == "reflect" ||
+          padding_mode == "replicate" || padding_mode == "circular",
+      "Unknown padding_mode ",
+      padding_mode,
+      ".");
+  TORCH_CHECK(
+      stride_.size() == 1 && padding_.size() == 1 && dilation_.size() == 1,
+      "conv1d expects a single stride, padding and dilation.");
+  TORCH_CHECK(weight.dim() == 3, "conv1d expects a 3-dimensional weight.");
+  int64_t stride = stride_[0];
+  int64_t padding = padding_[0];
+  int64_t dilation = dilation_[0];
+  TORCH_CHECK(stride > 0, "conv1d expects a positive stride.");
+  TORCH_CHECK(dilation > 0, "conv1d expects a positive dilation.");
+  TORCH_CHECK(padding >= 0, "conv1d expects a non-negative padding.");
+  auto impl = get_nested_tensor_impl(input);
+  auto nested_size = impl->nested_size();
+  const SizeTable& table = *nested_size;
+  TORCH_CHECK(
+      impl->nested_dim() == 1 && table.tensor_dim() == 2,
+      "Can only run conv1d on constiuents of size [channels, length].");
+  int64_t num_leaves = table.num_leaves();
+  if (num_leaves == 0) {
+    return wrap_tensor_node(TensorNode(std::vector<TensorNode>()));
+  }
+  TORCH_CHECK(
+      table.uniform()[0],
+      "conv1d requires all constiuents to have the same number of channels.");
+  int64_t channels = *table.uniform()[0];
+  int64_t out_channels = weight.size(0);
+  int64_t field = dilation * (weight.size(2) - 1) + 1;
+
+  // Start of each padded constiuent in the long sequence and the number of
+  // outputs that only read from within it.
+  std::vector<int64_t> starts(num_leaves);
+  std::vector<int64_t> out_lengths(num_leaves);
+  int64_t width = 0;
+  for (int64_t i = 0; i < num_leaves; i++) {
+    int64_t length = table.get(i, 1);
+    TORCH_CHECK(
+        padding_mode == "zeros" || padding < length ||
+            (padding_mode == "circular" && padding <= length),
+        "Padding of ",
+        padding,
+        " is too large for a constiuent of length ",
+        length,
+        " in padding_mode ",
+        padding_mode,
+        ".");
+    int64_t padded = length + 2 * padding;
+    TORCH_CHECK(
+        padded >= field,
+        "A constiuent of length ",
+        length,
+        " is too short for a kernel covering ",
+        field,
+        " elements.");
+    starts[i] = width;
+    out_lengths[i] = (padded - field) / stride + 1;
+    width += (padded + stride - 1) / stride * stride;
+  }
+
+  // Moves every constiuent into its place in the long sequence, which is
+  // zero in between, and fills the padding for the other padding modes.
+  std::vector<at::Tensor> leaves =
+      flatten(get_nested_tensor_structure(input)).vec();
+  Tensor sequence = at::zeros({channels, width}, leaves[0].options());
+  for (int64_t i = 0; i < num_leaves; i++) {
+    const at::Tensor& t = leaves[i];
+    int64_t length = t.size(1);
+    sequence.narrow(1, starts[i] + padding, length).copy_(t);
+    if (padding_mode == "zeros" || padding == 0) {
+      continue;
+    }
+    at::Tensor left;
+    at::Tensor right;
+    if (padding_mode == "reflect") {
+      left = t.narrow(1, 1, padding).flip({1});
+      right = t.narrow(1, length - 1 - padding, padding).flip({1});
+    } else if (padding_mode == "replicate") {
+      left = t.narrow(1, 0, 1).expand({channels, padding});
+      right = t.narrow(1, length - 1, 1).expand({channels, padding});
+    } else {
+      left = t.narrow(1, length - padding, padding);
+      right = t.narrow(1, 0, padding);
+    }
+    sequence.narrow(1, starts[i], padding).copy_(left);
+    sequence.narrow(1, starts[i] + padding + length, padding).copy_(right);
+  }
+  Tensor output = at::conv1d(
+                      sequence.unsqueeze(0),
+                      weight,
+                      bias ? *bias : Tensor(),
+                      {stride},
+                      {0},
+                      {dilation},
+                      groups)
+                      .squeeze(0);
+
+  std::vector<TensorNode> children;
+  for (int64_t i = 0; i < num_leaves; i++) {
+    children.emplace_back(
+        TensorNode(output.narrow(1, starts[i] / stride, out_lengths[i])));
+  }
+  TensorNode structure(std::move(children));
+  if (!arena_eligible(structure)) {
+    return wrap_tensor_node(std::move(structure));
+  }
+  // Without autograd the outputs are packed into a buffer of their own.
+  NestedTensor result = arena_empty_like(structure);
+  apply(
+      [](at::Tensor& result, at::Tensor& tensor) { result.copy_(tensor); },
+      result.get_structure(),
+      structure);
+  return wrap_nested_tensor(std::move(result));
+}
+
+Tensor NestedTensor_conv1d(
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups) {
+  auto impl = get_nested_tensor_impl(input);
+  if (impl->nested_dim() == 1 && impl->nested_size()->tensor_dim() == 2) {
+    c10::optional<Tensor> bias_;
+    if (bias.defined()) {
+      bias_ = bias;
+    }
+    return NestedTensor_conv1d_padded(
+        input, weight, bias_, stride, padding, dilation, groups, "zeros");
+  }
+  NestedTensorOpScope::record_fallback();
+  return wrap_tensor_node(batched_map(
+      [&](at::Tensor t) {
+        return at::conv1d(t, weight, bias, stride, padding, dilation, groups);
       },
-      get_nested_tensor_structure(input)));
+      input));
 }
 
 Tensor NestedTensor_max_pool2d(
@@ -53,36 +447,13 @@ Tensor NestedTensor_max_pool2d(
     IntArrayRef padding,
     IntArrayRef dilation,
     bool ceil_mode) {
-  auto self_impl = get_nested_tensor_impl(self);
-  auto nt = self_impl->_data;
-  auto tensor_node = get_nested_tensor_structure(self);
-
-  if (is_tensor_shape(self)) {
-    std::vector<at::Tensor> tensors;
-    for (auto tn : tensor_node.unbind()) {
-      tensors.push_back(tn.payload());
-    }
-
-    auto res = at::max_pool2d(
-        at::stack(tensors), kernel_size, stride, padding, dilation, ceil_mode);
-
-    return NestedTensorImpl(
-               torch::nested_tensor::NestedTensor(std::move(res)))
-        .to_nested_tensor(self_impl->nested_dim() - 1);
+  auto fn = [&](at::Tensor t) {
+    return at::max_pool2d(t, kernel_size, stride, padding, dilation, ceil_mode);
+  };
+  if (auto result = dense_batched_map(fn, self)) {
+    return *result;
   }
-
-  return wrap_tensor_node(map(
-      [&](at::Tensor t) {
-        return at::max_pool2d(
-                   t.unsqueeze(0),
-                   kernel_size,
-                   stride,
-                   padding,
-                   dilation,
-                   ceil_mode)
-            .squeeze(0);
-      },
-      get_nested_tensor_structure(self)));
+  return wrap_tensor_node(batched_map(fn, self));
 }
 
 Tensor NestedTensor_batch_norm(
@@ -95,6 +466,28 @@ Tensor NestedTensor_batch_norm(
     double momentum,
     double eps,
     bool cudnn_enabled) {
+  // NOTE: In eval mode each entry of a batch is normalized independently
+  // with the running statistics, so we can batch. During training the
+  // statistics are per constiuent.
+  if (!training && running_mean.defined() && running_var.defined()) {
+    auto fn = [&](at::Tensor t) {
+      return at::batch_norm(
+          t,
+          weight,
+          bias,
+          running_mean,
+          running_var,
+          training,
+          momentum,
+          eps,
+          cudnn_enabled);
+    };
+    if (auto result = dense_batched_map(fn, input)) {
+      return *result;
+    }
+    return wrap_tensor_node(batched_map(fn, input));
+  }
+  NestedTensorOpScope::record_fallback();
   return wrap_tensor_node(map(
       [&](at::Tensor t) {
         auto result = at::batch_norm(
@@ -114,6 +507,14 @@ Tensor NestedTensor_batch_norm(
 }
 
 Tensor NestedTensor_sum(const Tensor& self, c10::optional<ScalarType> dtype) {
+  if (!dtype) {
+    if (auto acc = _accumulate_type(self.scalar_type())) {
+      return NestedTensor_sum(self, *acc).to(self.scalar_type());
+    }
+  }
+  if (is_packed(self)) {
+    return at::sum(*get_nested_tensor(self).get_buffer(), dtype);
+  }
   auto tensors = flatten(
       map([&dtype](at::Tensor tensor) { return at::sum(tensor, dtype); },
           get_nested_tensor_structure(self)));
@@ -144,6 +545,22 @@ Tensor NestedTensor_reshape(const Tensor& self, IntArrayRef size) {
   for (int64_t i = nested_dim; i < int64_t(size.size()); i++) {
     target_shape.push_back(size[i]);
   }
+  auto nested_size = self_data->nested_size();
+  const SizeTable& table = *nested_size;
+  std::vector<std::vector<int64_t>> leaf_sizes;
+  for (int64_t leaf = 0; leaf < table.num_leaves(); leaf++) {
+    std::vector<int64_t> leaf_size = table.get(leaf);
+    int64_t numel = std::accumulate(
+        leaf_size.begin(),
+        leaf_size.end(),
+        int64_t(1),
+        std::multiplies<int64_t>());
+    leaf_sizes.push_back(at::infer_size(target_shape, numel));
+  }
+  if (auto result = packed_view(self, leaf_sizes)) {
+    return *result;
+  }
+  NestedTensorOpScope::record_fallback();
   return wrap_tensor_node(map(
       [target_shape](const at::Tensor t) {
         return at::reshape(t, IntArrayRef(target_shape));
@@ -151,6 +568,130 @@ Tensor NestedTensor_reshape(const Tensor& self, IntArrayRef size) {
       get_nested_tensor_structure(self)));
 }
 
+// Builds the node at depth level of the result, after nested dimension
+// level has been swapped with nested dimension dim. nodes are the nodes
+// at depth level of the input, indexed by the original index at dim0.
+TensorNode _transpose_nested_level(
+    const std::vector<TensorNode>& nodes,
+    int64_t level,
+    int64_t dim1,
+    size_t index1) {
+  std::vector<TensorNode> children;
+  if (level == dim1) {
+    for (const auto& node : nodes) {
+      children.push_back(node.children(index1));
+    }
+    return TensorNode(std::move(children));
+  }
+  size_t degree = nodes[0].degree();
+  for (size_t i = 0; i < degree; i++) {
+    std::vector<TensorNode> next;
+    for (const auto& node : nodes) {
+      TORCH_CHECK(
+          node.degree() == degree,
+          "Cannot transpose nested dimensions with irregular nested sizes in between.");
+      next.push_back(node.children(i));
+    }
+    children.push_back(
+        _transpose_nested_level(next, level + 1, dim1, index1));
+  }
+  return TensorNode(std::move(children));
+}
+
+// Swaps nested dimensions dim0 < dim1 by reindexing the tree. Constiuents
+// are reused as they are.
+TensorNode _transpose_nested(
+    const TensorNode& node,
+    int64_t dim0,
+    int64_t dim1) {
+  if (dim0 > 0) {
+    std::vector<TensorNode> children;
+    for (const auto& child : node.unbind()) {
+      children.push_back(_transpose_nested(child, dim0 - 1, dim1 - 1));
+    }
+    return TensorNode(std::move(children));
+  }
+  if (node.degree() == 0) {
+    return node;
+  }
+  // Nodes at depth dim1 must all agree on their degree, which becomes the
+  // degree at depth dim0 of the result.
+  std::vector<TensorNode> nodes = node.unbind();
+  for (int64_t level = 1; level < dim1; level++) {
+    std::vector<TensorNode> next;
+    for (const auto& n : nodes) {
+      for (const auto& child : n.unbind()) {
+        next.push_back(child);
+      }
+    }
+    nodes = std::move(next);
+  }
+  size_t degree1 = nodes.size() > 0 ? nodes[0].degree() : 0;
+  for (const auto& n : nodes) {
+    TORCH_CHECK(
+        n.degree() == degree1,
+        "Cannot transpose nested dimensions ",
+        dim0,
+        " and ",
+        dim1,
+        " of irregular nested size.");
+  }
+  std::vector<TensorNode> children;
+  for (size_t i = 0; i < degree1; i++) {
+    children.push_back(
+        _transpose_nested_level(node.unbind(), 1, dim1, i));
+  }
+  return TensorNode(std::move(children));
+}
+
+at::Tensor _stack_regular(const TensorNode& node) {
+  if (node.is_leaf()) {
+    return node.payload();
+  }
+  TORCH_CHECK(
+      node.degree() > 0,
+      "Cannot transpose a nested dimension with a tensor dimension of an empty NestedTensor.");
+  std::vector<at::Tensor> tensors;
+  for (const auto& child : node.unbind()) {
+    tensors.push_back(_stack_regular(child));
+    TORCH_CHECK(
+        tensors.back().sizes().equals(tensors[0].sizes()),
+        "Cannot transpose a nested dimension with a tensor dimension ",
+        "unless the nested size is regular below it.");
+  }
+  return at::stack(tensors);
+}
+
+TensorNode _unstack(const at::Tensor& tensor, int64_t height) {
+  if (height == 0) {
+    return TensorNode(at::Tensor(tensor));
+  }
+  std::vector<TensorNode> children;
+  for (const auto& t : tensor.unbind(0)) {
+    children.push_back(_unstack(t, height - 1));
+  }
+  return TensorNode(std::move(children));
+}
+
+// Swaps nested dimension dim0 with tensor dimension dim1. The subtrees
+// below dim0 are gathered into regular tensors, transposed and then split
+// back up along the same number of nested dimensions.
+TensorNode _transpose_nested_tensor(
+    const TensorNode& node,
+    int64_t dim0,
+    int64_t dim1) {
+  if (dim0 > 0) {
+    std::vector<TensorNode> children;
+    for (const auto& child : node.unbind()) {
+      children.push_back(_transpose_nested_tensor(child, dim0 - 1, dim1 - 1));
+    }
+    return TensorNode(std::move(children));
+  }
+  int64_t height = node.height();
+  at::Tensor stacked = _stack_regular(node);
+  return _unstack(stacked.transpose(0, dim1), height);
+}
+
 Tensor NestedTensor_transpose(const Tensor& self, int64_t dim0, int64_t dim1) {
   auto self_data = get_nested_tensor_impl(self);
   auto ndims = self.dim();
@@ -159,15 +700,22 @@ Tensor NestedTensor_transpose(const Tensor& self, int64_t dim0, int64_t dim1) {
   if (dim0 == dim1) {
     return self;
   }
+  if (dim0 > dim1) {
+    std::swap(dim0, dim1);
+  }
   int64_t nested_dim = self_data->nested_dim();
-  TORCH_CHECK(
-      dim0 >= nested_dim && dim1 >= nested_dim,
-      "Transposition of nested dimensions is not implemented yet.");
+  auto structure = get_nested_tensor_structure(self);
+  if (dim1 < nested_dim) {
+    return wrap_tensor_node(_transpose_nested(structure, dim0, dim1));
+  }
+  if (dim0 < nested_dim) {
+    return wrap_tensor_node(_transpose_nested_tensor(structure, dim0, dim1));
+  }
   return wrap_tensor_node(map(
       [dim0, dim1, nested_dim](const at::Tensor t) {
         return at::transpose(t, dim0 - nested_dim, dim1 - nested_dim);
       },
-      get_nested_tensor_structure(self)));
+      structure));
 }
 
 Tensor NestedTensor_softmax(
@@ -181,9 +729,20 @@ Tensor NestedTensor_softmax(
       dim >= nested_dim,
       "Cannot apply softmax across nested dimensions ",
       std::to_string(dim));
+  auto fn = [dtype](const at::Tensor t, int64_t dim) {
+    if (!dtype) {
+      if (auto acc = _upcast_type(t)) {
+        return at::softmax(t, dim, *acc).to(t.scalar_type());
+      }
+    }
+    return at::softmax(t, dim, dtype);
+  };
+  if (auto dense = dense_view(input)) {
+    return wrap_dense(fn(*dense, dim), nested_dim);
+  }
   return wrap_tensor_node(map(
-      [dim, nested_dim, dtype](const at::Tensor t) {
-        return at::softmax(t, dim - nested_dim, dtype);
+      [&fn, dim, nested_dim](const at::Tensor t) {
+        return fn(t, dim - nested_dim);
       },
       get_nested_tensor_structure(input)));
 }
@@ -203,11 +762,25 @@ Tensor NestedTensor_layer_norm(
       input_data.sizes()[input.dim() - 1],
       "Cannot normalize across irregular dimension ",
       std::to_string(input.dim() - 1));
-  return wrap_tensor_node(map(
-      [normalized_shape, &weight, &bias, eps](const at::Tensor t) {
-        return at::layer_norm(t, normalized_shape, weight, bias, eps, true);
-      },
-      input_data.get_structure()));
+  auto acc = _upcast_type(input);
+  Tensor acc_weight = acc && weight.defined() ? weight.to(*acc) : weight;
+  Tensor acc_bias = acc && bias.defined() ? bias.to(*acc) : bias;
+  auto fn = [normalized_shape, &acc_weight, &acc_bias, eps, acc](
+                const at::Tensor t) {
+    if (!acc) {
+      return at::layer_norm(
+          t, normalized_shape, acc_weight, acc_bias, eps, true);
+    }
+    return at::layer_norm(
+               t.to(*acc), normalized_shape, acc_weight, acc_bias, eps, true)
+        .to(t.scalar_type());
+  };
+  if (auto dense = dense_view(input)) {
+    return wrap_dense(fn(*dense), input_data.get_structure().height());
+  }
+  return wrap_tensor_node(
+      map([&fn](const at::Tensor t) { return fn(t); },
+          input_data.get_structure()));
 }
 
 Tensor& NestedTensor_add_(Tensor& self, const Tensor& other, Scalar alpha) {
@@ -225,7 +798,7 @@ Tensor& NestedTensor_add_(Tensor& self, const Tensor& other, Scalar alpha) {
 }
 
 Tensor NestedTensor_all(const Tensor& self) {
-  auto self_impl = get_nested_tensor_impl(self)->_data;
+  auto self_impl = get_nested_tensor_impl(self)->data();
   if (self.numel() == 0) {
     // XXX: self.options doesn't work here because
     // we don't want a Tensor backed by a NestedTensor
@@ -245,7 +818,7 @@ Tensor NestedTensor_all(const Tensor& self) {
 }
 
 Tensor NestedTensor_any(const Tensor& self) {
-  auto self_impl = get_nested_tensor_impl(self)->_data;
+  auto self_impl = get_nested_tensor_impl(self)->data();
   if (self.numel() == 0) {
     // XXX: self.options doesn't work here because
     // we don't want a Tensor backed by a NestedTensor
@@ -271,7 +844,7 @@ Tensor NestedTensor__log_softmax(
   auto self_impl = get_nested_tensor_impl(input_);
   return at::detail::make_tensor<NestedTensorImpl>(
       map([&](Tensor a) { return at::_log_softmax(a, dim_, half_to_float); },
-          self_impl->_data.get_structure()));
+          self_impl->data().get_structure()));
 }
 
 Tensor NestedTensor_matmul(const Tensor& self, const Tensor& other) {
@@ -281,6 +854,15 @@ Tensor NestedTensor_matmul(const Tensor& self, const Tensor& other) {
         get_nested_tensor_structure(self),
         get_nested_tensor_structure(other)));
   }
+  // NOTE: Batching only preserves semantics if other doesn't broadcast
+  // against the nested dimensions.
+  if (other.dim() <= 2) {
+    auto dense = dense_view(self);
+    int64_t nested_dim = get_nested_tensor_impl(self)->nested_dim();
+    if (dense && dense->dim() > nested_dim) {
+      return wrap_dense(at::matmul(*dense, other), nested_dim);
+    }
+  }
   return wrap_tensor_node(
       map([&other](Tensor tensor) { return at::matmul(tensor, other); },
           get_nested_tensor_structure(self)));
@@ -318,6 +900,28 @@ Tensor NestedTensor_flatten(
       start_dim >= nested_dim, "Cannot flatten nested dimension ", start_dim);
   TORCH_CHECK(
       end_dim >= nested_dim, "Cannot flatten nested dimension ", end_dim);
+  auto nested_size = self_data->nested_size();
+  const SizeTable& table = *nested_size;
+  std::vector<std::vector<int64_t>> leaf_sizes;
+  for (int64_t leaf = 0; leaf < table.num_leaves(); leaf++) {
+    std::vector<int64_t> leaf_size;
+    int64_t flat_size = 1;
+    for (int64_t dim = 0; dim < table.tensor_dim(); dim++) {
+      if (dim < start_dim - nested_dim || dim > end_dim - nested_dim) {
+        leaf_size.push_back(table.get(leaf, dim));
+        continue;
+      }
+      flat_size *= table.get(leaf, dim);
+      if (dim == end_dim - nested_dim) {
+        leaf_size.push_back(flat_size);
+      }
+    }
+    leaf_sizes.push_back(leaf_size);
+  }
+  if (auto result = packed_view(self, leaf_sizes)) {
+    return *result;
+  }
+  NestedTensorOpScope::record_fallback();
   return wrap_tensor_node(map(
       [start_dim, end_dim, nested_dim](at::Tensor tensor) {
         return at::flatten(
@@ -327,23 +931,24 @@ Tensor NestedTensor_flatten(
 }
 
 TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
-  m.impl_UNBOXED("conv2d", NestedTensor_conv2d);
-  m.impl_UNBOXED("batch_norm", NestedTensor_batch_norm);
-  m.impl_UNBOXED("max_pool2d", NestedTensor_max_pool2d);
-  m.impl_UNBOXED("dropout", NestedTensor_dropout);
-  m.impl_UNBOXED("dropout_", NestedTensor_dropout_);
-  m.impl_UNBOXED("sum", NestedTensor_sum);
-  m.impl_UNBOXED("add_.Tensor", NestedTensor_add_);
-  m.impl_UNBOXED("any", NestedTensor_any);
-  m.impl_UNBOXED("all", NestedTensor_all);
-  m.impl_UNBOXED("_log_softmax", NestedTensor__log_softmax);
-  m.impl_UNBOXED("reshape", NestedTensor_reshape);
-  m.impl_UNBOXED("transpose.int", NestedTensor_transpose);
-  m.impl_UNBOXED("softmax.int", NestedTensor_softmax);
-  m.impl_UNBOXED("layer_norm", NestedTensor_layer_norm);
-  m.impl_UNBOXED("matmul", NestedTensor_matmul);
-  m.impl_UNBOXED("matmul.out", NestedTensor_matmul_out);
-  m.impl_UNBOXED("pin_memory", NestedTensor_pin_memory);
-  m.impl_UNBOXED("flatten.using_ints", NestedTensor_flatten);
+  NESTED_TENSOR_IMPL("conv1d", NestedTensor_conv1d);
+  NESTED_TENSOR_IMPL("conv2d", NestedTensor_conv2d);
+  NESTED_TENSOR_IMPL("batch_norm", NestedTensor_batch_norm);
+  NESTED_TENSOR_IMPL("max_pool2d", NestedTensor_max_pool2d);
+  NESTED_TENSOR_IMPL("dropout", NestedTensor_dropout);
+  NESTED_TENSOR_IMPL("dropout_", NestedTensor_dropout_);
+  NESTED_TENSOR_IMPL("sum", NestedTensor_sum);
+  NESTED_TENSOR_IMPL("add_.Tensor", NestedTensor_add_);
+  NESTED_TENSOR_IMPL("any", NestedTensor_any);
+  NESTED_TENSOR_IMPL("all", NestedTensor_all);
+  NESTED_TENSOR_IMPL("_log_softmax", NestedTensor__log_softmax);
+  NESTED_TENSOR_IMPL("reshape", NestedTensor_reshape);
+  NESTED_TENSOR_IMPL("transpose.int", NestedTensor_transpose);
+  NESTED_TENSOR_IMPL("softmax.int", NestedTensor_softmax);
+  NESTED_TENSOR_IMPL("layer_norm", NestedTensor_layer_norm);
+  NESTED_TENSOR_IMPL("matmul", NestedTensor_matmul);
+  NESTED_TENSOR_IMPL("matmul.out", NestedTensor_matmul_out);
+  NESTED_TENSOR_IMPL("pin_memory", NestedTensor_pin_memory);
+  NESTED_TENSOR_IMPL("flatten.using_ints", NestedTensor_flatten);
 }
 } // namespace at
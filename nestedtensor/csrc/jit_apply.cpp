@@ -0,0 +1,132 @@
+#include <ATen/Parallel.h>
+#include <nestedtensor/csrc/jit_apply.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+at::Tensor _run(torch::jit::Function& fn, const at::Tensor& input) {
+  c10::IValue result = fn({c10::IValue(input)});
+  TORCH_CHECK(
+      result.isTensor(),
+      "jit_apply expects fn to return a Tensor, but got ",
+      result.tagKind(),
+      ".");
+  return result.toTensor();
+}
+
+// Groups of constiuent indices that run as one task.
+std::vector<std::vector<int64_t>> _tasks(
+    const std::vector<at::Tensor>& leaves,
+    bool batch) {
+  std::vector<std::vector<int64_t>> tasks;
+  if (!batch) {
+    for (size_t i = 0; i < leaves.size(); i++) {
+      tasks.push_back({int64_t(i)});
+    }
+    return tasks;
+  }
+  std::map<std::tuple<std::vector<int64_t>, int64_t, std::string>, size_t>
+      groups;
+  for (size_t i = 0; i < leaves.size(); i++) {
+    auto key = std::make_tuple(
+        leaves[i].sizes().vec(),
+        static_cast<int64_t>(leaves[i].scalar_type()),
+        leaves[i].device().str());
+    auto it = groups.find(key);
+    if (it == groups.end()) {
+      groups[key] = tasks.size();
+      tasks.push_back({int64_t(i)});
+    } else {
+      tasks[it->second].push_back(i);
+    }
+  }
+  return tasks;
+}
+
+void _run_task(
+    torch::jit::Function& fn,
+    const std::vector<at::Tensor>& leaves,
+    const std::vector<int64_t>& task,
+    std::vector<at::Tensor>& results) {
+  if (task.size() == 1) {
+    results[task[0]] = _run(fn, leaves[task[0]]);
+    return;
+  }
+  std::vector<at::Tensor> inputs;
+  for (int64_t i : task) {
+    inputs.push_back(leaves[i]);
+  }
+  at::Tensor output = _run(fn, at::stack(inputs));
+  TORCH_CHECK(
+      output.dim() > 0 && output.size(0) == int64_t(task.size()),
+      "jit_apply with batch=True expects fn to preserve the leading ",
+      "dimension, but got a result of size ",
+      output.sizes(),
+      " for a batch of ",
+      task.size(),
+      " constiuents.");
+  std::vector<at::Tensor> outputs = output.unbind(0);
+  for (size_t j = 0; j < task.size(); j++) {
+    results[task[j]] = outputs[j];
+  }
+}
+
+} // namespace
+
+at::Tensor jit_apply(
+    torch::jit::Function& fn,
+    const at::Tensor& nt,
+    bool batch) {
+  TensorNode structure = at::get_nested_tensor_structure(nt);
+  std::vector<at::Tensor> leaves = flatten(structure).vec();
+  std::vector<at::Tensor> results(leaves.size());
+  std::vector<std::vector<int64_t>> tasks = _tasks(leaves, batch);
+
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t remaining = tasks.size();
+  std::exception_ptr error;
+  // NOTE: The last task runs on the calling thread, which would otherwise
+  // just wait.
+  for (size_t i = 0; i < tasks.size(); i++) {
+    auto task_fn = [&, i]() {
+      try {
+        _run_task(fn, leaves, tasks[i], results);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      std::lock_guard<std::mutex> guard(mutex);
+      if (--remaining == 0) {
+        done.notify_all();
+      }
+    };
+    if (i + 1 < tasks.size()) {
+      at::launch(task_fn);
+    } else {
+      task_fn();
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining]() { return remaining == 0; });
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return at::wrap_tensor_node(
+      unflatten(structure, c10::List<at::Tensor>(results)));
+}
+
+} // namespace nested_tensor
+} // namespace torch
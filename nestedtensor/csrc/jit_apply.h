@@ -0,0 +1,18 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <torch/csrc/jit/api/compilation_unit.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// Runs fn on every constiuent of nt and returns the results as a
+// NestedTensor of the same structure. Constiuents are processed
+// concurrently on the inter-op thread pool.
+//
+// If batch is true, constiuents of equal size, dtype and device are stacked
+// and fn runs once on each such batch. This is only correct for functions
+// that treat the leading dimension as a batch dimension.
+at::Tensor jit_apply(torch::jit::Function& fn, const at::Tensor& nt, bool batch);
+
+} // namespace nested_tensor
+} // namespace torch
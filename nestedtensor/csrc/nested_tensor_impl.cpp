@@ -1,10 +1,13 @@
 #include <ATen/WrapDimUtils.h>
 #include <ATen/core/op_registration/op_registration.h>
+#include <nestedtensor/csrc/arena.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/profiling.h>
 #include <torch/csrc/jit/runtime/operator.h>
 #include <torch/library.h>
 #include <ATen/ATen.h>
 #include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <algorithm>
 
 namespace torch {
 namespace nested_tensor {
@@ -19,38 +22,8 @@ int64_t num_memory(c10::List<int64_t> size, c10::List<int64_t> stride) {
   return size[0] * stride[0];
 }
 
-std::vector<c10::optional<int64_t>> construct_size(const SizeNode& size_node) {
-  if (size_node.is_leaf()) {
-    std::vector<c10::optional<int64_t>> result;
-    for (const auto& size : size_node.payload()) {
-      result.push_back(size);
-    }
-    return result;
-  }
-  std::vector<c10::optional<int64_t>> result;
-  result.push_back(size_node.degree());
-
-  if (size_node.degree() > 0) {
-    for (const auto& size : construct_size(size_node.children(0))) {
-      result.push_back(size);
-    }
-    for (size_t i = 1; i < size_node.degree(); i++) {
-      auto size_node_i = construct_size(size_node.children(i));
-      for (size_t j = 1; j < result.size(); j++) {
-        if (result[j] && ((*result[j]) != size_node_i[j - 1])) {
-          result[j] = c10::nullopt;
-        }
-      }
-    }
-  }
-
-  return result;
-}
-
 std::vector<c10::optional<int64_t>> NestedTensor::sizes() const {
-  return construct_size(
-      map([](at::Tensor tensor) { return c10::List<int64_t>(tensor.sizes()); },
-          get_structure()));
+  return construct_size(nested_size_table(get_structure()));
 }
 
 c10::List<int64_t> _cont_stride(c10::List<int64_t> size) {
@@ -86,11 +59,29 @@ TensorNode _unbind_tensors(TensorNode structure) {
 }
 
 NestedTensor::NestedTensor(TensorNode&& structure)
-    : _structure(structure),
+    : _structure(std::move(structure)),
       _first_variable(
           get_first_leaf(_structure) ? *get_first_leaf(_structure)
                                      : at::ones({})) {}
 
+NestedTensor::NestedTensor(at::Tensor&& buffer, TensorNode&& structure)
+    : _buffer(std::move(buffer)),
+      _structure(std::move(structure)),
+      _first_variable(
+          get_first_leaf(_structure) ? *get_first_leaf(_structure)
+                                     : at::ones({})) {}
+
+NestedTensor::NestedTensor(
+    TensorNode&& structure,
+    const at::Tensor& first_variable)
+    : _structure(std::move(structure)),
+      _first_variable(
+          get_first_leaf(_structure)
+              ? *get_first_leaf(_structure)
+              : at::empty(
+                    std::vector<int64_t>(first_variable.dim(), 0),
+                    first_variable.options())) {}
+
 inline TensorNode _squeeze_nested_dim(TensorNode structure, int64_t dim) {
   if (dim == 0) {
     return structure.children(0);
@@ -105,25 +96,14 @@ namespace at {
 
 using namespace torch::nested_tensor;
 
-at::Tensor _to_tensor(TensorNode node) {
-  // TODO: Recursive stacking is expensive.
+// Stacks all constiuents at once and views the result in the final shape,
+// so that each constiuent is copied exactly once no matter the nested_dim.
+at::Tensor _to_tensor(TensorNode node, const at::TensorOptions& options) {
   if (node.is_leaf()) {
     return node.payload();
   }
-  if (node.degree() == 0) {
-    return at::empty({0});
-  }
-  std::vector<at::Tensor> flat;
-  for (auto child : node.unbind()) {
-    flat.push_back(_to_tensor(child));
-  }
-  return stack(flat);
-}
-
-at::Tensor NestedTensorImpl::to_tensor() {
-  // TODO: Not necessarily a view because of stack and reshape.
   std::vector<int64_t> new_size;
-  for (const auto& si : _data.sizes()) {
+  for (const auto& si : construct_size(nested_size_table(node))) {
     if (!si) {
       // TODO: This assumes we'll extend to_tensor to also work with int64_t at
       // this level.
@@ -132,9 +112,96 @@ at::Tensor NestedTensorImpl::to_tensor() {
     }
     new_size.push_back(*si);
   }
-  return _to_tensor(get_structure());
+  std::vector<at::Tensor> leaves = flatten(node).vec();
+  if (leaves.size() == 0) {
+    // E.g. empty lists at every level, which stack can't handle.
+    return at::empty(new_size, options);
+  }
+  return at::stack(leaves).view(new_size);
+}
+
+at::Tensor NestedTensorImpl::to_tensor() {
+  // TODO: Not necessarily a view because of stack and reshape.
+  return _to_tensor(get_structure(), data().get_first_variable().options());
+}
+
+// Replaces each subtree at depth dim with a Tensor.
+TensorNode _to_tensor_at(
+    const TensorNode& node,
+    int64_t dim,
+    const at::TensorOptions& options) {
+  if (dim == 0) {
+    return TensorNode(_to_tensor(node, options));
+  }
+  std::vector<TensorNode> result;
+  for (const auto& child : node.unbind()) {
+    result.push_back(_to_tensor_at(child, dim - 1, options));
+  }
+  return TensorNode(std::move(result));
 }
 
+// Largest size of each dimension across all entries.
+void _padded_size(
+    const TensorNode& node,
+    int64_t depth,
+    std::vector<int64_t>& result) {
+  if (node.is_leaf()) {
+    for (int64_t i = 0; i < node.payload().dim(); i++) {
+      result[depth + i] = std::max(result[depth + i], node.payload().size(i));
+    }
+    return;
+  }
+  result[depth] = std::max(result[depth], int64_t(node.degree()));
+  for (const auto& child : node.unbind()) {
+    _padded_size(child, depth + 1, result);
+  }
+}
+
+void _copy_padded(const TensorNode& node, at::Tensor result) {
+  if (node.is_leaf()) {
+    at::Tensor tensor = node.payload();
+    for (int64_t i = 0; i < tensor.dim(); i++) {
+      result = result.narrow(i, 0, tensor.size(i));
+    }
+    result.copy_(tensor);
+    return;
+  }
+  for (size_t i = 0; i < node.degree(); i++) {
+    _copy_padded(node.children(i), result.select(0, i));
+  }
+}
+
+void NestedTensorImpl::set_data(torch::nested_tensor::NestedTensor data) {
+  std::shared_ptr<const Version> version =
+      std::make_shared<Version>(std::move(data));
+  std::atomic_store(&_current, version);
+}
+
+void NestedTensorImpl::requires_grad_(bool requires_grad) {
+  bool changed = false;
+  TensorNode structure = map(
+      [requires_grad, &changed](at::Tensor tensor) {
+        if (tensor.requires_grad() == requires_grad) {
+          return tensor;
+        }
+        TORCH_CHECK(
+            tensor.is_leaf(),
+            "You can only change requires_grad flags of leaf variables.");
+        changed = true;
+        return tensor.detach().requires_grad_(requires_grad);
+      },
+      get_structure());
+  if (!changed) {
+    return;
+  }
+  // The detached constiuents still view the same memory, so the buffer
+  // stays valid.
+  if (auto buffer = data().get_buffer()) {
+    set_data(NestedTensor(std::move(*buffer), std::move(structure)));
+  } else {
+    set_data(NestedTensor(std::move(structure)));
+  }
+}
 
 Tensor NestedTensorImpl::to_nested_tensor(c10::optional<int64_t> dim__) {
   int64_t dim_ = 0;
@@ -149,9 +216,10 @@ Tensor NestedTensorImpl::to_nested_tensor(c10::optional<int64_t> dim__) {
     for (int64_t i = 0; i < (dim - nested_dim()); i++) {
       unbound = _unbind_tensors(unbound);
     }
-    return at::detail::make_tensor<NestedTensorImpl>(NestedTensorImpl(std::move(unbound)));
+    return at::detail::make_tensor<NestedTensorImpl>(
+        NestedTensor(std::move(unbound)));
   }
-  return at::detail::make_tensor<NestedTensorImpl>(_data);
+  return at::detail::make_tensor<NestedTensorImpl>(data());
 }
 
 
@@ -168,7 +236,7 @@ at::NestedTensorImpl* get_nested_tensor_impl(const at::Tensor tensor) {
 
 torch::nested_tensor::NestedTensor get_nested_tensor(
     const at::Tensor tensor) {
-  return get_nested_tensor_impl(tensor)->_data;
+  return get_nested_tensor_impl(tensor)->data();
 }
 
 torch::nested_tensor::TensorNode get_nested_tensor_structure(
@@ -187,12 +255,69 @@ at::Tensor wrap_tensor_node(
       torch::nested_tensor::NestedTensor(std::move(result)));
 }
 
+// The cached metadata belongs to a single version, so a concurrent set_data
+// can't leave stale entries behind.
+std::shared_ptr<const SizeTable> NestedTensorImpl::nested_size() const {
+  std::shared_ptr<const Version> version = _version();
+  auto table = std::atomic_load(&version->nested_size);
+  if (!table) {
+    std::shared_ptr<const SizeTable> expected;
+    table = std::make_shared<const SizeTable>(
+        nested_size_table(version->data.get_structure()));
+    if (!std::atomic_compare_exchange_strong(
+            &version->nested_size, &expected, table)) {
+      table = expected;
+    }
+  }
+  return table;
+}
+
+std::shared_ptr<const BucketPlan> NestedTensorImpl::bucket_plan() const {
+  std::shared_ptr<const Version> version = _version();
+  auto plan = std::atomic_load(&version->bucket_plan);
+  if (!plan) {
+    std::shared_ptr<const BucketPlan> expected;
+    plan = build_bucket_plan(flatten(version->data.get_structure()).vec());
+    if (!std::atomic_compare_exchange_strong(
+            &version->bucket_plan, &expected, plan)) {
+      plan = expected;
+    }
+  }
+  return plan;
+}
+
 IntArrayRef NestedTensorImpl::sizes() const {
-  return IntArrayRef(_sizes);
+  std::shared_ptr<const Version> version = _version();
+  auto sizes = std::atomic_load(&version->sizes);
+  if (!sizes) {
+    std::vector<int64_t> new_sizes;
+    for (auto opt_int : construct_size(*nested_size())) {
+      if (opt_int) {
+        new_sizes.push_back(*opt_int);
+      }
+    }
+    {
+      std::lock_guard<std::mutex> guard(_sizes_mutex);
+      auto interned = std::find_if(
+          _sizes.begin(),
+          _sizes.end(),
+          [&new_sizes](const std::shared_ptr<const std::vector<int64_t>>& s) {
+            return *s == new_sizes;
+          });
+      if (interned == _sizes.end()) {
+        _sizes.push_back(std::make_shared<const std::vector<int64_t>>(
+            std::move(new_sizes)));
+        interned = _sizes.end() - 1;
+      }
+      sizes = *interned;
+    }
+    std::atomic_store(&version->sizes, sizes);
+  }
+  return IntArrayRef(*sizes);
 }
 
 int64_t NestedTensorImpl::size(int64_t dim) const {
-  std::vector<c10::optional<int64_t>> size = _data.sizes();
+  std::vector<c10::optional<int64_t>> size = construct_size(*nested_size());
   if (size[dim]) {
     return *(size[dim]);
   }
@@ -210,11 +335,107 @@ Tensor NestedTensor_contiguous(const Tensor& self, MemoryFormat memory_format) {
   TORCH_CHECK(
       memory_format != MemoryFormat::Preserve,
       "preserve memory format is unsupported by the contiguous operator");
+  auto structure = get_nested_tensor_impl(self)->get_structure();
+  if (memory_format == MemoryFormat::Contiguous &&
+      arena_eligible(structure)) {
+    NestedTensor result = arena_empty_like(structure);
+    apply(
+        [](at::Tensor& result, at::Tensor& tensor) { result.copy_(tensor); },
+        result.get_structure(),
+        structure);
+    return wrap_nested_tensor(std::move(result));
+  }
+  NestedTensorOpScope::record_fallback();
   return wrap_tensor_node(
       map([](at::Tensor tensor) { return tensor.contiguous(); },
           get_nested_tensor_impl(self)->get_structure()));
 }
 
+Tensor NestedTensor_to_dtype(Tensor tensor, ScalarType dtype) {
+  if (tensor.scalar_type() == dtype) {
+    return tensor;
+  }
+  auto impl_data = get_nested_tensor_impl(tensor);
+  const TensorNode& structure = impl_data->get_structure();
+  if (arena_eligible(structure)) {
+    NestedTensor result = arena_empty_like(
+        structure,
+        impl_data->data().get_first_variable().options().dtype(dtype));
+    auto buffer = impl_data->data().get_buffer();
+    if (buffer && tensor.is_contiguous() &&
+        buffer->numel() == result.get_buffer()->numel()) {
+      // Converts all constiuents in a single pass over the buffer.
+      result.get_buffer()->copy_(*buffer);
+    } else {
+      apply(
+          [](at::Tensor& result, at::Tensor& tensor) { result.copy_(tensor); },
+          result.get_structure(),
+          structure);
+    }
+    return wrap_nested_tensor(std::move(result));
+  }
+  NestedTensorOpScope::record_fallback();
+  return wrap_tensor_node(
+      map([dtype](at::Tensor tensor) { return tensor.to(dtype); },
+          structure));
+}
+
+bool is_packed(const Tensor& tensor) {
+  auto impl_data = get_nested_tensor_impl(tensor);
+  auto buffer = impl_data->data().get_buffer();
+  return buffer && buffer->numel() == tensor.numel() &&
+      tensor.is_contiguous() && arena_eligible(impl_data->get_structure());
+}
+
+c10::optional<Tensor> dense_view(const Tensor& tensor) {
+  auto impl_data = get_nested_tensor_impl(tensor);
+  if (impl_data->nested_size()->num_leaves() == 0 ||
+      !is_tensor_shape(tensor) || !is_packed(tensor)) {
+    return c10::nullopt;
+  }
+  return impl_data->data().get_buffer()->view(tensor.sizes());
+}
+
+TensorNode _dense_node(at::Tensor dense, int64_t nested_dim) {
+  if (nested_dim == 0) {
+    return TensorNode(std::move(dense));
+  }
+  std::vector<TensorNode> children;
+  for (at::Tensor child : dense.unbind(0)) {
+    children.push_back(_dense_node(child, nested_dim - 1));
+  }
+  return TensorNode(std::move(children));
+}
+
+Tensor wrap_dense(Tensor dense, int64_t nested_dim) {
+  dense = dense.contiguous();
+  TensorNode structure = _dense_node(dense, nested_dim);
+  return wrap_nested_tensor(
+      NestedTensor(dense.reshape({-1}), std::move(structure)));
+}
+
+c10::optional<Tensor> packed_view(
+    const Tensor& tensor,
+    const std::vector<std::vector<int64_t>>& sizes) {
+  if (!is_packed(tensor)) {
+    return c10::nullopt;
+  }
+  auto impl_data = get_nested_tensor_impl(tensor);
+  at::Tensor new_buffer = *impl_data->data().get_buffer();
+  int64_t offset = 0;
+  size_t index = 0;
+  TensorNode structure = map(
+      [&new_buffer, &offset, &index, &sizes](at::Tensor leaf) {
+        at::Tensor view =
+            new_buffer.narrow(0, offset, leaf.numel()).view(sizes[index++]);
+        offset += leaf.numel();
+        return view;
+      },
+      impl_data->get_structure());
+  return wrap_nested_tensor(
+      NestedTensor(std::move(new_buffer), std::move(structure)));
+}
+
 Tensor NestedTensor_to_tensor(Tensor tensor, c10::optional<int64_t> dim_) {
   auto impl_data = get_nested_tensor_impl(tensor);
   if (!dim_) {
@@ -226,27 +447,23 @@ Tensor NestedTensor_to_tensor(Tensor tensor, c10::optional<int64_t> dim_) {
   }
   // If dim is bigger than nested_dim the NestedTensor is already
   // of Tensor for dimensions bigger than the given.
-  if (impl_data->nested_dim() == 1) {
+  if (dim >= impl_data->nested_dim()) {
     return tensor;
   }
-  // At this point nested_dim is at least 2. That means any unbind
-  // operation of a child must yield NestedTensors.
-  // If dim is 1 then we'll apply to_tensor(0) to the children and must expect
-  // Tensors.
-  std::vector<at::Tensor> unbound = at::unbind(tensor, 0);
-  std::vector<TensorNode> result;
-  for (Tensor child : unbound) {
-    auto ci = NestedTensor_to_tensor(child, dim - 1);
-    if (is_nested_tensor_impl(ci)) {
-      auto s = get_nested_tensor(ci).get_structure();
-      result.push_back(TensorNode(std::move(s)));
-    } else {
-      // TODO: If it's a NestedTensor instance get the structure
-      result.push_back(TensorNode(std::move(ci)));
-    }
-  }
-  return at::detail::make_tensor<at::NestedTensorImpl>(
-      NestedTensor(TensorNode(std::move(result))));
+  return wrap_tensor_node(_to_tensor_at(
+      impl_data->get_structure(),
+      dim,
+      impl_data->data().get_first_variable().options()));
+}
+
+Tensor NestedTensor_to_padded_tensor(Tensor tensor, Scalar padding) {
+  auto impl_data = get_nested_tensor_impl(tensor);
+  std::vector<int64_t> size(impl_data->dim(), 0);
+  _padded_size(impl_data->get_structure(), 0, size);
+  at::Tensor result =
+      at::full(size, padding, impl_data->data().get_first_variable().options());
+  _copy_padded(impl_data->get_structure(), result);
+  return result;
 }
 
 bool NestedTensor_is_pinned(const Tensor& self) {
@@ -316,29 +533,263 @@ std::vector<at::Tensor> NestedTensor_unbind(const at::Tensor &self, int64_t dim)
 Tensor NestedTensor_select(const Tensor& self, int64_t dim, int64_t index) {
   int64_t ndim = self.dim();
   dim = maybe_wrap_dim(dim, ndim);
-  if (dim == 0) {
+  if (dim != 0) {
     TORCH_CHECK_INDEX(false, "select() only supports dim == 0 for now.");
   }
-  TensorNode tn = get_nested_tensor(self).get_structure().unbind()[index];
-  torch::nested_tensor::NestedTensor nt = torch::nested_tensor::NestedTensor(
-      std::move(tn));
-  return at::detail::make_tensor<NestedTensorImpl>(std::move(nt));
+  auto structure = get_nested_tensor_structure(self);
+  int64_t degree = structure.degree();
+  TORCH_CHECK_INDEX(
+      index >= -degree && index < degree,
+      "select(): index ",
+      index,
+      " out of range for NestedTensor of size ",
+      degree,
+      " at dimension 0");
+  if (index < 0) {
+    index += degree;
+  }
+  TensorNode tn = structure.children(index);
+  if (tn.is_leaf()) {
+    return tn.payload();
+  }
+  return wrap_tensor_node(std::move(tn));
+}
+
+// Returns the part of buffer that backs the constiuents of structure or
+// nullopt if they aren't laid out back-to-back within it. Only looks at
+// the first and last constiuent, so this is constant time for a given
+// nested_dim.
+c10::optional<at::Tensor> _narrow_buffer(
+    const at::Tensor& buffer,
+    const TensorNode& structure) {
+  TensorNode first = structure;
+  TensorNode last = structure;
+  while (!first.is_leaf()) {
+    if (first.degree() == 0 || last.degree() == 0) {
+      return c10::nullopt;
+    }
+    first = first.children(0);
+    last = last.children(last.degree() - 1);
+  }
+  int64_t start = first.payload().storage_offset() - buffer.storage_offset();
+  int64_t end = last.payload().storage_offset() - buffer.storage_offset() +
+      last.payload().numel();
+  return buffer.narrow(0, start, end - start);
+}
+
+// Narrows the nested dimension 0 without touching the constiuents.
+Tensor _narrow_nested(
+    const Tensor& self,
+    int64_t start,
+    int64_t length) {
+  auto nt = get_nested_tensor(self);
+  TensorNode structure = nt.get_structure().narrow(start, length);
+  if (auto buffer = nt.get_buffer()) {
+    if (auto narrowed = _narrow_buffer(*buffer, structure)) {
+      return wrap_nested_tensor(
+          NestedTensor(std::move(*narrowed), std::move(structure)));
+    }
+  }
+  return wrap_nested_tensor(
+      NestedTensor(std::move(structure), nt.get_first_variable()));
+}
+
+Tensor NestedTensor_narrow(
+    const Tensor& self,
+    int64_t dim,
+    int64_t start,
+    int64_t length) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  auto self_impl = get_nested_tensor_impl(self);
+  int64_t nested_dim = self_impl->nested_dim();
+  if (dim == 0) {
+    int64_t degree = self_impl->get_structure().degree();
+    if (start < 0) {
+      start += degree;
+    }
+    TORCH_CHECK(
+        start >= 0 && length >= 0 && start + length <= degree,
+        "start (",
+        start,
+        ") + length (",
+        length,
+        ") exceeds dimension size (",
+        degree,
+        ").");
+    return _narrow_nested(self, start, length);
+  }
+  if (dim < nested_dim) {
+    std::vector<TensorNode> children;
+    for (auto child : self_impl->get_structure().unbind()) {
+      at::Tensor narrowed = NestedTensor_narrow(
+          wrap_tensor_node(std::move(child)), dim - 1, start, length);
+      children.push_back(get_nested_tensor_structure(narrowed));
+    }
+    return wrap_nested_tensor(NestedTensor(
+        TensorNode(std::move(children)),
+        self_impl->data().get_first_variable()));
+  }
+  return wrap_tensor_node(
+      map([dim, start, length, nested_dim](at::Tensor tensor) {
+            return tensor.narrow(dim - nested_dim, start, length);
+          },
+          self_impl->get_structure()));
+}
+
+Tensor NestedTensor_slice(
+    const Tensor& self,
+    int64_t dim,
+    int64_t start,
+    int64_t end,
+    int64_t step) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  TORCH_CHECK(step > 0, "slice step must be positive");
+  auto self_impl = get_nested_tensor_impl(self);
+  int64_t nested_dim = self_impl->nested_dim();
+  if (dim >= nested_dim) {
+    return wrap_tensor_node(
+        map([dim, start, end, step, nested_dim](at::Tensor tensor) {
+              return at::slice(tensor, dim - nested_dim, start, end, step);
+            },
+            self_impl->get_structure()));
+  }
+  TORCH_CHECK(
+      dim == 0, "slice() only supports nested dimension 0 for now.");
+  // Same clamping as at::slice.
+  int64_t degree = self_impl->get_structure().degree();
+  if (start < 0) {
+    start += degree;
+  }
+  if (end < 0) {
+    end += degree;
+  }
+  start = std::min(std::max(start, int64_t(0)), degree);
+  end = std::min(std::max(end, start), degree);
+  if (step == 1) {
+    return _narrow_nested(self, start, end - start);
+  }
+  std::vector<TensorNode> children;
+  for (int64_t i = start; i < end; i += step) {
+    children.push_back(self_impl->get_structure().children(i));
+  }
+  // NOTE: Narrow to select nothing so that the nested_dim is kept.
+  TensorNode selected = children.size() == 0
+      ? self_impl->get_structure().narrow(0, 0)
+      : TensorNode(std::move(children));
+  return wrap_nested_tensor(NestedTensor(
+      std::move(selected), self_impl->data().get_first_variable()));
+}
+
+Tensor NestedTensor_index_select(
+    const Tensor& self,
+    int64_t dim,
+    const Tensor& index) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  TORCH_CHECK(dim == 0, "index_select() only supports dim == 0 for now.");
+  TORCH_CHECK_INDEX(
+      index.dim() <= 1, "index_select(): Index is supposed to be a vector");
+  TORCH_CHECK(
+      index.scalar_type() == ScalarType::Long,
+      "index_select(): Expected dtype int64 for index");
+  auto structure = get_nested_tensor_structure(self);
+  int64_t degree = structure.degree();
+  at::Tensor index_cpu = index.reshape({-1}).to(at::kCPU).contiguous();
+  const int64_t* index_data = index_cpu.data_ptr<int64_t>();
+  std::vector<TensorNode> children;
+  for (int64_t i = 0; i < index_cpu.numel(); i++) {
+    int64_t j = index_data[i];
+    TORCH_CHECK_INDEX(
+        j >= -degree && j < degree,
+        "index_select(): index ",
+        j,
+        " out of range for NestedTensor of size ",
+        degree,
+        " at dimension 0");
+    children.push_back(structure.children(j < 0 ? j + degree : j));
+  }
+  // NOTE: Narrow to select nothing so that the nested_dim is kept.
+  TensorNode selected = children.size() == 0
+      ? structure.narrow(0, 0)
+      : TensorNode(std::move(children));
+  std::vector<at::Tensor> leaves = flatten(selected).vec();
+  if (leaves.size() == 0) {
+    return wrap_nested_tensor(NestedTensor(
+        std::move(selected), get_nested_tensor(self).get_first_variable()));
+  }
+
+  if (arena_eligible(selected)) {
+    NestedTensor result = arena_empty_like(selected);
+    std::vector<at::Tensor> result_leaves =
+        flatten(result.get_structure()).vec();
+    int64_t numel = result.get_buffer()->numel();
+    auto copy = [&leaves, &result_leaves](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        result_leaves[i].copy_(leaves[i]);
+      }
+    };
+    if (result_leaves[0].is_cpu()) {
+      // Aim for GRAIN_SIZE elements per task.
+      int64_t grain_size = std::max<int64_t>(
+          1,
+          at::internal::GRAIN_SIZE * int64_t(leaves.size()) /
+              std::max<int64_t>(1, numel));
+      at::parallel_for(0, leaves.size(), grain_size, copy);
+    } else {
+      copy(0, leaves.size());
+    }
+    return wrap_nested_tensor(std::move(result));
+  }
+
+  // NOTE: The backward of at::cat splits the gradient back up into the
+  // selected constiuents. Autograd accumulates the gradients of repeated
+  // indices, which amounts to an index_add into the source.
+  std::vector<at::Tensor> flat;
+  for (const auto& leaf : leaves) {
+    flat.push_back(leaf.reshape({-1}));
+  }
+  at::Tensor buffer = at::cat(flat);
+  int64_t offset = 0;
+  TensorNode result = map(
+      [&buffer, &offset](at::Tensor leaf) {
+        at::Tensor view =
+            buffer.narrow(0, offset, leaf.numel()).view(leaf.sizes());
+        offset += leaf.numel();
+        return view;
+      },
+      selected);
+  return wrap_nested_tensor(NestedTensor(std::move(buffer), std::move(result)));
 }
 
 Tensor NestedTensor_clone(const Tensor& src, c10::optional<c10::MemoryFormat> optional_memory_format) {
   auto self_impl = get_nested_tensor_impl(src);
+  auto memory_format =
+      optional_memory_format.value_or(MemoryFormat::Preserve);
+  // Preserving the memory format of contiguous constiuents also
+  // yields contiguous constiuents, which we can pack.
+  if ((memory_format == MemoryFormat::Contiguous ||
+       (memory_format == MemoryFormat::Preserve &&
+        src.is_contiguous())) &&
+      arena_eligible(self_impl->get_structure())) {
+    NestedTensor result = arena_empty_like(self_impl->get_structure());
+    apply(
+        [](at::Tensor& result, at::Tensor& tensor) { result.copy_(tensor); },
+        result.get_structure(),
+        self_impl->get_structure());
+    return wrap_nested_tensor(std::move(result));
+  }
+  NestedTensorOpScope::record_fallback();
   return at::detail::make_tensor<NestedTensorImpl>(
       map([&optional_memory_format](Tensor a) {
           return at::clone(a, optional_memory_format);
           }, 
-          self_impl->_data.get_structure()));
+          self_impl->data().get_structure()));
 }
 
 Tensor& NestedTensor_copy_(Tensor& self, const Tensor& src, bool non_blocking) {
   auto self_data = get_nested_tensor_impl(self);
   auto src_data = get_nested_tensor_impl(src);
   TORCH_CHECK(
-      shape_matches(self_data->nested_size(), src_data->nested_size()),
+      shape_matches(*self_data->nested_size(), *src_data->nested_size()),
       "self and source don't match in shape");
   apply(
       [](at::Tensor& self, at::Tensor& source) { return self.copy_(source); },
@@ -353,7 +804,7 @@ Tensor _NestedTensor_squeeze_(Tensor self, c10::optional<int64_t> dim_) {
     // TODO: First dimension is always ignored.
     // We could decide to return a Tensor if the 0th
     // dimension can be squeezed.
-    auto init_sizes = self_impl->_data.sizes();
+    auto init_sizes = construct_size(*self_impl->nested_size());
     for (size_t i = 0; i < init_sizes.size() - 1; i++) {
       int64_t index = init_sizes.size() - i - 1;
       c10::optional<int64_t> s = init_sizes[index];
@@ -365,15 +816,33 @@ Tensor _NestedTensor_squeeze_(Tensor self, c10::optional<int64_t> dim_) {
   }
   int64_t dim = at::maybe_wrap_dim(*dim_, self.dim());
   TORCH_CHECK(dim > 0, "Cannot squeeze first dimension.");
+  std::vector<c10::optional<int64_t>> sizes =
+      construct_size(*self_impl->nested_size());
   TORCH_CHECK(
-      ((get_nested_tensor_impl(self)->_data.sizes()[dim]) &&
-       ((*(get_nested_tensor_impl(self)->_data.sizes()[dim])) == 1)),
+      sizes[dim] && *sizes[dim] == 1,
       "Given dimension is either undefined or not a singleton.");
-  if (dim < get_nested_tensor_impl(self)->nested_dim()) {
-    return wrap_tensor_node(
-        _squeeze_nested_dim(self_impl->get_structure(), dim));
+  int64_t height = self_impl->nested_dim();
+  if (dim < height) {
+    TensorNode structure =
+        _squeeze_nested_dim(self_impl->get_structure(), dim);
+    // The constiuents themselves don't change, so neither does the buffer.
+    if (auto buffer = self_impl->data().get_buffer()) {
+      return wrap_nested_tensor(
+          NestedTensor(std::move(*buffer), std::move(structure)));
+    }
+    return wrap_tensor_node(std::move(structure));
+  }
+  auto nested_size = self_impl->nested_size();
+  const SizeTable& table = *nested_size;
+  std::vector<std::vector<int64_t>> leaf_sizes;
+  for (int64_t leaf = 0; leaf < table.num_leaves(); leaf++) {
+    leaf_sizes.push_back(table.get(leaf));
+    leaf_sizes.back().erase(leaf_sizes.back().begin() + (dim - height));
+  }
+  if (auto result = packed_view(self, leaf_sizes)) {
+    return *result;
   }
-  int64_t height = self_impl->get_structure().height();
+  NestedTensorOpScope::record_fallback();
   return wrap_tensor_node(map(
       [dim, height](at::Tensor tensor) { return tensor.squeeze(dim - height); },
       self_impl->get_structure()));
@@ -381,39 +850,49 @@ Tensor _NestedTensor_squeeze_(Tensor self, c10::optional<int64_t> dim_) {
 
 Tensor& NestedTensor_squeeze_(Tensor& self) {
   auto new_tensor = _NestedTensor_squeeze_(self, c10::nullopt);
-  auto self_impl = get_nested_tensor_impl(self);
-  self_impl->_data = get_nested_tensor_impl(new_tensor)->_data;
+  // Nothing to squeeze, so there is no need for a new version.
+  if (new_tensor.is_same(self)) {
+    return self;
+  }
+  get_nested_tensor_impl(self)->set_data(
+      get_nested_tensor_impl(new_tensor)->data());
   return self;
 }
 
 Tensor& NestedTensor_squeeze__dim(Tensor& self, int64_t dim) {
   auto new_tensor = _NestedTensor_squeeze_(self, dim);
-  auto self_impl = get_nested_tensor_impl(self);
-  self_impl->_data = get_nested_tensor_impl(new_tensor)->_data;
+  get_nested_tensor_impl(self)->set_data(
+      get_nested_tensor_impl(new_tensor)->data());
   return self;
 }
 
+// NOTE: Squeezing only creates views, so self is left untouched.
 Tensor NestedTensor_squeeze(const Tensor& self) {
-  auto new_tensor = NestedTensor_clone(self, c10::nullopt);
-  return _NestedTensor_squeeze_(new_tensor, c10::nullopt);
+  auto result = _NestedTensor_squeeze_(self, c10::nullopt);
+  if (result.is_same(self)) {
+    return wrap_nested_tensor(get_nested_tensor(self));
+  }
+  return result;
 }
 
 Tensor NestedTensor_squeeze_dim(const Tensor& self, int64_t dim) {
-  auto new_tensor = NestedTensor_clone(self, c10::nullopt);
-  return _NestedTensor_squeeze_(new_tensor, dim);
+  return _NestedTensor_squeeze_(self, dim);
 }
 
 TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
-  m.impl_UNBOXED("clone", NestedTensor_clone);
-  m.impl_UNBOXED("copy_", NestedTensor_copy_);
-  m.impl_UNBOXED("squeeze_", NestedTensor_squeeze_);
-  m.impl_UNBOXED("squeeze_.dim", NestedTensor_squeeze__dim);
-  m.impl_UNBOXED("squeeze", NestedTensor_squeeze);
-  m.impl_UNBOXED("squeeze.dim", NestedTensor_squeeze_dim);
-  m.impl_UNBOXED("contiguous", NestedTensor_contiguous);
-  m.impl_UNBOXED("is_pinned", NestedTensor_is_pinned);
-  m.impl_UNBOXED("unbind.int", NestedTensor_unbind);
-  m.impl_UNBOXED("select.int", NestedTensor_select);
+  NESTED_TENSOR_IMPL("clone", NestedTensor_clone);
+  NESTED_TENSOR_IMPL("copy_", NestedTensor_copy_);
+  NESTED_TENSOR_IMPL("squeeze_", NestedTensor_squeeze_);
+  NESTED_TENSOR_IMPL("squeeze_.dim", NestedTensor_squeeze__dim);
+  NESTED_TENSOR_IMPL("squeeze", NestedTensor_squeeze);
+  NESTED_TENSOR_IMPL("squeeze.dim", NestedTensor_squeeze_dim);
+  NESTED_TENSOR_IMPL("contiguous", NestedTensor_contiguous);
+  NESTED_TENSOR_IMPL("is_pinned", NestedTensor_is_pinned);
+  NESTED_TENSOR_IMPL("unbind.int", NestedTensor_unbind);
+  NESTED_TENSOR_IMPL("select.int", NestedTensor_select);
+  NESTED_TENSOR_IMPL("narrow", NestedTensor_narrow);
+  NESTED_TENSOR_IMPL("slice.Tensor", NestedTensor_slice);
+  NESTED_TENSOR_IMPL("index_select", NestedTensor_index_select);
 }
 
 }
@@ -1,6 +1,11 @@
 #pragma once
+#include <nestedtensor/csrc/size_table.h>
 #include <nestedtensor/csrc/utils/nested_node.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
 #include <ATen/ATen.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace torch {
 namespace nested_tensor {
@@ -14,6 +19,11 @@ using IntegerNode = NestedNode<int64_t>;
 struct NestedTensor {
   NestedTensor() = delete;
   NestedTensor(TensorNode&& structure);
+  NestedTensor(at::Tensor&& buffer, TensorNode&& structure);
+  // For structures that may lack leaves, such as an empty selection. Then
+  // an empty Tensor of first_variable's dimension, dtype and device stands
+  // in for them.
+  NestedTensor(TensorNode&& structure, const at::Tensor& first_variable);
   std::vector<c10::optional<int64_t>> sizes() const;
   TensorNode& get_structure() {
     return _structure;
@@ -24,8 +34,14 @@ struct NestedTensor {
   const at::Tensor get_first_variable() const {
     return _first_variable;
   }
+  // If set, all constiuents are contiguous views into this flat Tensor
+  // and laid out back-to-back in the order of the structure's leaves.
+  c10::optional<at::Tensor> get_buffer() const {
+    return _buffer;
+  }
 
  private:
+  c10::optional<at::Tensor> _buffer;
   TensorNode _structure;
   at::Tensor _first_variable;
 };
@@ -55,16 +71,10 @@ struct NestedTensorImpl : public c10::TensorImpl {
             c10::DispatchKeySet(NestedTensorKey),
             data.get_first_variable().dtype(),
             data.get_first_variable().device()),
-        _data(data) {
-            for (auto opt_int : _data.sizes()) {
-              if (opt_int) {
-                _sizes.push_back(*opt_int);
-              }
-            }
-        }
+        _current(std::make_shared<Version>(std::move(data))) {}
 
   int64_t dim() const override {
-    return _data.get_first_variable().dim() + nested_dim();
+    return data().get_first_variable().dim() + nested_dim();
   }
   int64_t numel() const override {
     auto fn = [](at::Tensor leaf, int64_t input) {
@@ -82,11 +92,13 @@ struct NestedTensorImpl : public c10::TensorImpl {
     };
     return reduce<decltype(fn), bool, at::Tensor>(get_structure(), fn, true);
   }
-  TensorNode& get_structure() {
-    return _data.get_structure();
+  // A snapshot of the current version of the constiuents. See _current.
+  // Copying a NestedTensor only copies the root of its structure.
+  torch::nested_tensor::NestedTensor data() const {
+    return _version()->data;
   }
-  const TensorNode& get_structure() const {
-    return _data.get_structure();
+  TensorNode get_structure() const {
+    return _version()->data.get_structure();
   }
   void backward(Tensor gradient, bool retain_graph, bool create_graph) {
     apply(
@@ -99,6 +111,13 @@ struct NestedTensorImpl : public c10::TensorImpl {
     return get_structure().height();
   }
   Tensor to_nested_tensor(c10::optional<int64_t> dim);
+  // Publishes data as the new version for in-place ops that change the
+  // metadata. Never modifies the current version.
+  void set_data(torch::nested_tensor::NestedTensor data);
+  // Replaces the constiuents whose requires_grad differs by detached ones and
+  // publishes them as a new version. Constiuents shared with other
+  // NestedTensors are never modified.
+  void requires_grad_(bool requires_grad);
   Tensor grad() {
     auto fn = [](at::Tensor leaf, bool input) {
       return input && leaf.grad().defined();
@@ -110,19 +129,11 @@ struct NestedTensorImpl : public c10::TensorImpl {
         map([](at::Tensor tensor) { 
           return tensor.grad(); }, get_structure()));
   }
-  Tensor requires_grad_(bool requires_grad) {
-    apply(
-        [requires_grad](at::Tensor& tensor) -> void {
-          tensor.set_requires_grad(requires_grad);
-        },
-        get_structure());
-    return at::detail::make_tensor<NestedTensorImpl>(_data);
-  }
   bool requires_grad() const {
-    return _data.get_first_variable().requires_grad();
+    return data().get_first_variable().requires_grad();
   }
   bool is_pinned() const {
-    return _data.get_first_variable().is_pinned();
+    return data().get_first_variable().is_pinned();
   }
   // This is a C++ representation of a nested list of torch.Sizes
   //
@@ -145,15 +156,12 @@ struct NestedTensorImpl : public c10::TensorImpl {
   //
   // That means, if the list is not empty it is either a list of
   // lists of numbers or a list of empty lists.
-  SizeNode nested_size() const {
-    return map(
-        [](at::Tensor tensor) { return c10::List<int64_t>(tensor.sizes()); },
-        get_structure());
-  }
-  SizeNode nested_stride() const {
-    return map(
-        [](at::Tensor tensor) { return c10::List<int64_t>(tensor.strides()); },
-        get_structure());
+  // Cached per version. Hold on to the result for as long as it is used.
+  std::shared_ptr<const SizeTable> nested_size() const;
+  // Bucketing plan for batched_map. Cached per version like nested_size.
+  std::shared_ptr<const BucketPlan> bucket_plan() const;
+  SizeTable nested_stride() const {
+    return nested_stride_table(get_structure());
   }
   at::Tensor to_tensor();
 
@@ -161,14 +169,41 @@ struct NestedTensorImpl : public c10::TensorImpl {
   int64_t size(int64_t dim) const override;
   IntArrayRef strides() const override;
 
-  torch::nested_tensor::NestedTensor _data;
-  std::vector<int64_t> _sizes;
+
+ private:
+  // A NestedTensor along with the metadata derived from it, which is
+  // computed on first use. Use std::atomic_load/compare_exchange to access
+  // the cached metadata.
+  struct Version {
+    explicit Version(torch::nested_tensor::NestedTensor data)
+        : data(std::move(data)) {}
+    const torch::nested_tensor::NestedTensor data;
+    mutable std::shared_ptr<const std::vector<int64_t>> sizes;
+    mutable std::shared_ptr<const SizeTable> nested_size;
+    mutable std::shared_ptr<const BucketPlan> bucket_plan;
+  };
+  std::shared_ptr<const Version> _version() const {
+    return std::atomic_load(&_current);
+  }
+
+  // NOTE: Versions are immutable once published, so any number of threads
+  // can read a NestedTensor concurrently without locking. In-place ops that
+  // change metadata (e.g. squeeze_) publish a new version instead of
+  // modifying the current one (copy-on-write). Readers hold on to a snapshot
+  // of the version they loaded, which is freed once the last of them is done
+  // with it. Use std::atomic_load/store to access.
+  std::shared_ptr<const Version> _current;
+  // NOTE: sizes() hands out an IntArrayRef, which can't keep a version
+  // alive. The sizes of all versions are interned here instead, so that
+  // there is one entry per distinct size. Guarded by _sizes_mutex.
+  mutable std::vector<std::shared_ptr<const std::vector<int64_t>>> _sizes;
+  mutable std::mutex _sizes_mutex;
 };
 
 
 inline bool is_tensor_shape(const at::Tensor tensor) {
-  auto nt = get_nested_tensor(tensor);
-  for (const auto& size : nt.sizes()) {
+  for (const auto& size :
+       construct_size(*get_nested_tensor_impl(tensor)->nested_size())) {
     if (!size) {
       return false;
     }
@@ -176,10 +211,88 @@ inline bool is_tensor_shape(const at::Tensor tensor) {
   return true;
 }
 
+// Converts all constiuents to dtype, in a single pass if there is a buffer.
+Tensor NestedTensor_to_dtype(Tensor tensor, ScalarType dtype);
+
+// Dropout with the mask derived from seed and the position of each element
+// in the packed layout, so that the same seed always yields the same mask.
+Tensor NestedTensor_dropout_with_seed(
+    const Tensor& input,
+    double p,
+    int64_t seed);
+// The mask NestedTensor_dropout_with_seed applies, as bool constiuents.
+Tensor NestedTensor_dropout_mask(const Tensor& input, double p, int64_t seed);
+// Dropout with a freshly drawn seed. Returns the result and the seed, which
+// is enough to recompute the mask.
+std::tuple<Tensor, int64_t> NestedTensor_fused_dropout(
+    const Tensor& input,
+    double p);
+
+// conv1d over constiuents of size [channels, length] in a single call, with
+// each constiuent padded on its own according to padding_mode, which is one
+// of zeros, reflect, replicate and circular.
+Tensor NestedTensor_conv1d_padded(
+    const Tensor& input,
+    const Tensor& weight,
+    const c10::optional<Tensor>& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation,
+    int64_t groups,
+    const std::string& padding_mode);
 Tensor NestedTensor_to_tensor(Tensor tensor, c10::optional<int64_t> dim_);
+// Pads all entries with padding to the largest size of each dimension and
+// writes every constiuent once into its place in the result.
+Tensor NestedTensor_to_padded_tensor(Tensor tensor, Scalar padding);
+// If all constiuents are laid out back-to-back in the buffer and don't
+// require grad, views the buffer with the given sizes, one per constiuent
+// and each of the same numel as the constiuent. The result shares the
+// buffer, so this only touches metadata. Returns nullopt otherwise.
+c10::optional<Tensor> packed_view(
+    const Tensor& tensor,
+    const std::vector<std::vector<int64_t>>& sizes);
+
+// Whether all constiuents are laid out back-to-back in the buffer and none
+// of them requires grad. Elementwise ops can then run on the buffer at once.
+bool is_packed(const Tensor& tensor);
+
+// NOTE: Regular batches, i.e. packed NestedTensors whose constiuents all
+// share a shape, are backed by a dense Tensor of size tensor.sizes(). Ops
+// can run a single ATen call on it instead of one per constiuent and wrap
+// the result via wrap_dense, which keeps it packed.
+c10::optional<Tensor> dense_view(const Tensor& tensor);
+Tensor wrap_dense(Tensor dense, int64_t nested_dim);
+
+// Runs fn once on the dense Tensor with all nested dimensions flattened
+// into the first one, if there is a dense Tensor. Like batched_map, fn
+// maps a batch of constiuents to a batch of results.
+template <class F>
+inline c10::optional<Tensor> dense_batched_map(F&& fn, const Tensor& tensor) {
+  auto dense = dense_view(tensor);
+  if (!dense) {
+    return c10::nullopt;
+  }
+  int64_t nested_dim = get_nested_tensor_impl(tensor)->nested_dim();
+  Tensor result = fn(dense->flatten(0, nested_dim - 1));
+  std::vector<int64_t> result_size(
+      dense->sizes().begin(), dense->sizes().begin() + nested_dim);
+  for (int64_t i = 1; i < result.dim(); i++) {
+    result_size.push_back(result.size(i));
+  }
+  return wrap_dense(result.reshape(result_size), nested_dim);
+}
+
+// Like batched_map on the structure of tensor, but reuses the bucketing plan
+// of its current version.
+template <class F>
+inline TensorNode batched_map(F&& fn, const Tensor& tensor) {
+  auto impl = get_nested_tensor_impl(tensor);
+  return torch::nested_tensor::batched_map(
+      std::forward<F>(fn), impl->get_structure(), *impl->bucket_plan());
+}
 
 inline std::ostream& operator<<(std::ostream& out, const NestedTensorImpl& batch_tensor) {
-  auto node = batch_tensor._data.get_structure();
+  auto node = batch_tensor.data().get_structure();
   out << "NESTED_TENSOR";
   apply([&out](at::Tensor tensor) { out << tensor << std::endl; }, node);
   out << std::endl;
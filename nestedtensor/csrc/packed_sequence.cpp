@@ -0,0 +1,277 @@
+#include <nestedtensor/csrc/packed_sequence.h>
+#include <nestedtensor/csrc/profiling.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <torch/library.h>
+#include <algorithm>
+#include <numeric>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+at::Tensor _index_tensor(const std::vector<int64_t>& index) {
+  return at::tensor(index, at::kLong);
+}
+
+std::vector<int64_t> _index_vector(const at::Tensor& index) {
+  at::Tensor cpu_index = index.to(at::kCPU, at::kLong).contiguous();
+  const int64_t* data = cpu_index.data_ptr<int64_t>();
+  return std::vector<int64_t>(data, data + cpu_index.numel());
+}
+
+// All constiuents concatenated along their first dimension. Only a view of
+// the buffer if there is one.
+at::Tensor _rows(const at::Tensor& tensor, const SizeTable& table, int64_t total) {
+  if (at::is_packed(tensor)) {
+    std::vector<int64_t> size = {total};
+    for (int64_t dim = 1; dim < table.tensor_dim(); dim++) {
+      size.push_back(*table.uniform()[dim]);
+    }
+    return at::get_nested_tensor(tensor).get_buffer()->view(size);
+  }
+  return at::cat(flatten(at::get_nested_tensor_structure(tensor)).vec(), 0);
+}
+
+} // namespace
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+nested_tensor_to_packed_sequence(const at::Tensor& tensor) {
+  auto impl = at::get_nested_tensor_impl(tensor);
+  TORCH_CHECK(
+      impl->nested_dim() == 1,
+      "Can only pack NestedTensors of nested_dim 1, but got nested_dim ",
+      impl->nested_dim(),
+      ".");
+  auto nested_size = impl->nested_size();
+  const SizeTable& table = *nested_size;
+  int64_t batch = table.num_leaves();
+  TORCH_CHECK(batch > 0, "Cannot pack an empty NestedTensor.");
+  TORCH_CHECK(
+      table.tensor_dim() > 0, "Sequences need to be at least 1-dimensional.");
+  for (int64_t dim = 1; dim < table.tensor_dim(); dim++) {
+    TORCH_CHECK(
+        table.uniform()[dim],
+        "All sequences need to be of the same size in all but the first dimension.");
+  }
+  std::vector<int64_t> lengths(batch);
+  std::vector<int64_t> offsets(batch);
+  int64_t total = 0;
+  for (int64_t i = 0; i < batch; i++) {
+    lengths[i] = table.get(i, 0);
+    TORCH_CHECK(lengths[i] > 0, "Sequences need to be of non-zero length.");
+    offsets[i] = total;
+    total += lengths[i];
+  }
+  std::vector<int64_t> sorted(batch);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [&lengths](int64_t a, int64_t b) {
+    return lengths[a] > lengths[b];
+  });
+  std::vector<int64_t> unsorted(batch);
+  for (int64_t j = 0; j < batch; j++) {
+    unsorted[sorted[j]] = j;
+  }
+
+  // Row of each constiuent that goes into the next row of data.
+  std::vector<int64_t> batch_sizes(lengths[sorted[0]]);
+  std::vector<int64_t> index;
+  index.reserve(total);
+  int64_t active = batch;
+  for (int64_t step = 0; step < int64_t(batch_sizes.size()); step++) {
+    while (lengths[sorted[active - 1]] <= step) {
+      active--;
+    }
+    batch_sizes[step] = active;
+    for (int64_t j = 0; j < active; j++) {
+      index.push_back(offsets[sorted[j]] + step);
+    }
+  }
+  at::Tensor rows = _rows(tensor, table, total);
+  at::Tensor data = rows.index_select(0, _index_tensor(index).to(rows.device()));
+  return std::make_tuple(
+      data,
+      _index_tensor(batch_sizes),
+      _index_tensor(sorted).to(data.device()),
+      _index_tensor(unsorted).to(data.device()));
+}
+
+// Checks that indices is a permutation of [0, batch).
+void _check_permutation(
+    const std::vector<int64_t>& indices,
+    int64_t batch,
+    const char* name) {
+  TORCH_CHECK(
+      int64_t(indices.size()) == batch,
+      "Expected ",
+      name,
+      " for ",
+      batch,
+      " sequences, but got ",
+      indices.size(),
+      ".");
+  std::vector<bool> seen(batch, false);
+  for (int64_t index : indices) {
+    TORCH_CHECK(
+        index >= 0 && index < batch && !seen[index],
+        name,
+        " needs to be a permutation of the sequences, but got ",
+        index,
+        ".");
+    seen[index] = true;
+  }
+}
+
+at::Tensor nested_tensor_from_packed_sequence(
+    const at::Tensor& data,
+    const at::Tensor& batch_sizes,
+    const c10::optional<at::Tensor>& sorted_indices,
+    const c10::optional<at::Tensor>& unsorted_indices) {
+  TORCH_CHECK(
+      batch_sizes.dim() == 1 && batch_sizes.numel() > 0,
+      "batch_sizes needs to be a non-empty 1-dimensional Tensor.");
+  TORCH_CHECK(data.dim() > 0, "data needs to be at least 1-dimensional.");
+  std::vector<int64_t> sizes = _index_vector(batch_sizes);
+  int64_t batch = sizes[0];
+  // First row of each step in data.
+  std::vector<int64_t> starts(sizes.size());
+  // Length of each sequence in sorted order.
+  std::vector<int64_t> lengths(batch, 0);
+  int64_t total = 0;
+  for (size_t step = 0; step < sizes.size(); step++) {
+    TORCH_CHECK(
+        sizes[step] > 0 && sizes[step] <= batch &&
+            (step == 0 || sizes[step] <= sizes[step - 1]),
+        "batch_sizes needs to be positive and non-increasing.");
+    starts[step] = total;
+    total += sizes[step];
+    for (int64_t j = 0; j < sizes[step]; j++) {
+      lengths[j]++;
+    }
+  }
+  TORCH_CHECK(
+      total == data.size(0),
+      "batch_sizes adds up to ",
+      total,
+      ", but data is of size ",
+      data.size(0),
+      " in its first dimension.");
+  std::vector<int64_t> unsorted(batch);
+  if (unsorted_indices) {
+    unsorted = _index_vector(*unsorted_indices);
+    _check_permutation(unsorted, batch, "unsorted_indices");
+  } else if (sorted_indices) {
+    std::vector<int64_t> sorted = _index_vector(*sorted_indices);
+    _check_permutation(sorted, batch, "sorted_indices");
+    for (int64_t j = 0; j < batch; j++) {
+      unsorted[sorted[j]] = j;
+    }
+  } else {
+    std::iota(unsorted.begin(), unsorted.end(), 0);
+  }
+
+  std::vector<int64_t> index;
+  index.reserve(total);
+  for (int64_t i = 0; i < batch; i++) {
+    int64_t j = unsorted[i];
+    for (int64_t step = 0; step < lengths[j]; step++) {
+      index.push_back(starts[step] + j);
+    }
+  }
+  at::Tensor rows = data.index_select(0, _index_tensor(index).to(data.device()));
+  std::vector<TensorNode> children;
+  int64_t offset = 0;
+  for (int64_t i = 0; i < batch; i++) {
+    int64_t length = lengths[unsorted[i]];
+    children.emplace_back(TensorNode(rows.narrow(0, offset, length)));
+    offset += length;
+  }
+  if (rows.requires_grad()) {
+    return at::wrap_tensor_node(TensorNode(std::move(children)));
+  }
+  return at::wrap_nested_tensor(
+      NestedTensor(rows.reshape({-1}), TensorNode(std::move(children))));
+}
+
+} // namespace nested_tensor
+} // namespace torch
+
+namespace at {
+
+using namespace torch::nested_tensor;
+
+// NOTE: The recurrent ops run on the PackedSequence layout of the input and
+// scatter the output back into a NestedTensor. The hidden states are in the
+// order of the constiuents. batch_first doesn't apply, since the sequences
+// aren't padded into a batch.
+std::tuple<Tensor, Tensor, Tensor> NestedTensor_lstm(
+    const Tensor& input,
+    TensorList hx,
+    TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    double dropout,
+    bool train,
+    bool bidirectional,
+    bool batch_first) {
+  TORCH_CHECK(
+      hx.size() == 2, "lstm expects two hidden states, but got ", hx.size(), ".");
+  Tensor data, batch_sizes, sorted_indices, unsorted_indices;
+  std::tie(data, batch_sizes, sorted_indices, unsorted_indices) =
+      nested_tensor_to_packed_sequence(input);
+  std::vector<Tensor> sorted_hx = {hx[0].index_select(1, sorted_indices),
+                                   hx[1].index_select(1, sorted_indices)};
+  Tensor output, h, c;
+  std::tie(output, h, c) = at::lstm(
+      data,
+      batch_sizes,
+      sorted_hx,
+      params,
+      has_biases,
+      num_layers,
+      dropout,
+      train,
+      bidirectional);
+  return std::make_tuple(
+      nested_tensor_from_packed_sequence(
+          output, batch_sizes, sorted_indices, unsorted_indices),
+      h.index_select(1, unsorted_indices),
+      c.index_select(1, unsorted_indices));
+}
+
+std::tuple<Tensor, Tensor> NestedTensor_gru(
+    const Tensor& input,
+    const Tensor& hx,
+    TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    double dropout,
+    bool train,
+    bool bidirectional,
+    bool batch_first) {
+  Tensor data, batch_sizes, sorted_indices, unsorted_indices;
+  std::tie(data, batch_sizes, sorted_indices, unsorted_indices) =
+      nested_tensor_to_packed_sequence(input);
+  Tensor output, h;
+  std::tie(output, h) = at::gru(
+      data,
+      batch_sizes,
+      hx.index_select(1, sorted_indices),
+      params,
+      has_biases,
+      num_layers,
+      dropout,
+      train,
+      bidirectional);
+  return std::make_tuple(
+      nested_tensor_from_packed_sequence(
+          output, batch_sizes, sorted_indices, unsorted_indices),
+      h.index_select(1, unsorted_indices));
+}
+
+TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
+  NESTED_TENSOR_IMPL("lstm.input", NestedTensor_lstm);
+  NESTED_TENSOR_IMPL("gru.input", NestedTensor_gru);
+}
+
+} // namespace at
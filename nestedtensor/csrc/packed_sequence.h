@@ -0,0 +1,28 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// Conversions between NestedTensors of sequences and the PackedSequence
+// layout of torch.nn.utils.rnn, without padding in between. The
+// NestedTensor is of nested_dim 1 and its constiuents are of size
+// [length, *] with non-zero lengths and equal trailing sizes.
+
+// Sorts the sequences by decreasing length, stable like
+// pack_padded_sequence(enforce_sorted=False), and gathers them time-major
+// into data of size [sum of lengths, *] in a single index_select. Returns
+// data, batch_sizes, sorted_indices and unsorted_indices.
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+nested_tensor_to_packed_sequence(const at::Tensor& tensor);
+
+// The reverse of nested_tensor_to_packed_sequence. Without sorted_indices
+// the sequences are expected in order of decreasing length.
+at::Tensor nested_tensor_from_packed_sequence(
+    const at::Tensor& data,
+    const at::Tensor& batch_sizes,
+    const c10::optional<at::Tensor>& sorted_indices,
+    const c10::optional<at::Tensor>& unsorted_indices);
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,92 @@
+#include <nestedtensor/csrc/profiling.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+struct OpStatsRegistry {
+  std::mutex mutex;
+  std::unordered_map<std::string, std::unique_ptr<NestedTensorOpStats>> stats;
+};
+
+// NOTE: Intentionally leaked. Kernels may still run during static
+// destruction and hold on to their stats.
+OpStatsRegistry& _registry() {
+  static OpStatsRegistry* registry = new OpStatsRegistry();
+  return *registry;
+}
+
+thread_local NestedTensorOpScope* _current_scope = nullptr;
+
+} // namespace
+
+NestedTensorOpStats& get_op_stats(const std::string& name) {
+  auto& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  auto& stats = registry.stats[name];
+  if (!stats) {
+    stats.reset(new NestedTensorOpStats());
+  }
+  return *stats;
+}
+
+c10::Dict<std::string, c10::Dict<std::string, int64_t>> op_stats() {
+  auto& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  c10::Dict<std::string, c10::Dict<std::string, int64_t>> result;
+  for (const auto& entry : registry.stats) {
+    const NestedTensorOpStats& stats = *entry.second;
+    if (stats.calls == 0) {
+      continue;
+    }
+    c10::Dict<std::string, int64_t> op_result;
+    op_result.insert("calls", stats.calls);
+    op_result.insert("leaves", stats.leaves);
+    op_result.insert("time_ns", stats.time_ns);
+    op_result.insert("fallbacks", stats.fallbacks);
+    result.insert(entry.first, op_result);
+  }
+  return result;
+}
+
+void reset_op_stats() {
+  auto& registry = _registry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  for (auto& entry : registry.stats) {
+    entry.second->calls = 0;
+    entry.second->leaves = 0;
+    entry.second->time_ns = 0;
+    entry.second->fallbacks = 0;
+  }
+}
+
+NestedTensorOpScope::NestedTensorOpScope(
+    NestedTensorOpStats& stats,
+    int64_t leaves)
+    : _stats(stats),
+      _parent(_current_scope),
+      _start(std::chrono::steady_clock::now()) {
+  _stats.calls++;
+  _stats.leaves += leaves;
+  _current_scope = this;
+}
+
+NestedTensorOpScope::~NestedTensorOpScope() {
+  auto elapsed = std::chrono::steady_clock::now() - _start;
+  _stats.time_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  _current_scope = _parent;
+}
+
+void NestedTensorOpScope::record_fallback() {
+  if (_current_scope) {
+    _current_scope->_stats.fallbacks++;
+  }
+}
+
+} // namespace nested_tensor
+} // namespace torch
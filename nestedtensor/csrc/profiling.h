@@ -0,0 +1,135 @@
+#pragma once
+#include <ATen/record_function.h>
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <atomic>
+#include <chrono>
+
+namespace torch {
+namespace nested_tensor {
+
+// Counters kept for every registered NestedTensor kernel. They are cheap
+// enough to stay on all the time.
+struct NestedTensorOpStats {
+  std::atomic<int64_t> calls{0};
+  // Constiuents of the first NestedTensor argument.
+  std::atomic<int64_t> leaves{0};
+  std::atomic<int64_t> time_ns{0};
+  // Calls that couldn't take a fast path and fell back to per-constiuent
+  // dispatch.
+  std::atomic<int64_t> fallbacks{0};
+};
+
+// Entries are never removed, so the returned reference stays valid.
+NestedTensorOpStats& get_op_stats(const std::string& name);
+// Returns calls, leaves, time_ns and fallbacks for every op called so far.
+c10::Dict<std::string, c10::Dict<std::string, int64_t>> op_stats();
+void reset_op_stats();
+
+// Times a kernel and counts it towards stats. Scopes nest per thread, so
+// that kernels can report a fallback without knowing their own stats.
+struct NestedTensorOpScope {
+  NestedTensorOpScope(NestedTensorOpStats& stats, int64_t leaves);
+  ~NestedTensorOpScope();
+  // Counts a fallback towards the innermost scope of the calling thread.
+  static void record_fallback();
+
+ private:
+  NestedTensorOpStats& _stats;
+  NestedTensorOpScope* _parent;
+  std::chrono::steady_clock::time_point _start;
+};
+
+inline const at::Tensor* _first_nested_tensor() {
+  return nullptr;
+}
+
+template <class... B>
+const at::Tensor* _first_nested_tensor(const at::Tensor& a, const B&... b);
+
+template <class A, class... B>
+const at::Tensor* _first_nested_tensor(const A& a, const B&... b) {
+  return _first_nested_tensor(b...);
+}
+
+template <class... B>
+const at::Tensor* _first_nested_tensor(const at::Tensor& a, const B&... b) {
+  if (a.defined() && at::is_nested_tensor_impl(a)) {
+    return &a;
+  }
+  return _first_nested_tensor(b...);
+}
+
+// Only visits the inner nodes and doesn't allocate, so e.g. for nested_dim
+// 1 this is just the degree of the root.
+inline int64_t _count_leaves(const TensorNode& node) {
+  if (node.is_leaf()) {
+    return 1;
+  }
+  if (node.height() == 1) {
+    return node.degree();
+  }
+  int64_t result = 0;
+  for (size_t i = 0; i < node.degree(); i++) {
+    result += _count_leaves(node.children(i));
+  }
+  return result;
+}
+
+inline int64_t _num_leaves(const at::Tensor* tensor) {
+  if (!tensor) {
+    return 0;
+  }
+  return _count_leaves(at::get_nested_tensor_structure(*tensor));
+}
+
+// Inputs reported to the profiler: number of constiuents, total number of
+// elements and total number of bytes of the first NestedTensor argument.
+// RECORD_FUNCTION only evaluates them while a profiler is active.
+inline std::vector<c10::IValue> _profiler_inputs(
+    const at::Tensor* tensor,
+    int64_t leaves) {
+  if (!tensor) {
+    return {};
+  }
+  int64_t numel = tensor->numel();
+  int64_t bytes = numel * tensor->dtype().itemsize();
+  return {c10::IValue(leaves), c10::IValue(numel), c10::IValue(bytes)};
+}
+
+template <class FuncType, FuncType func>
+struct _profiled_kernel;
+
+template <class R, class... Args, R (*func)(Args...)>
+struct _profiled_kernel<R (*)(Args...), func> {
+  static std::string& name() {
+    static std::string name;
+    return name;
+  }
+  static R call(Args... args) {
+    static NestedTensorOpStats& stats = get_op_stats(name());
+    const at::Tensor* input = _first_nested_tensor(args...);
+    int64_t leaves = _num_leaves(input);
+    NestedTensorOpScope scope(stats, leaves);
+    RECORD_FUNCTION(name().c_str(), _profiler_inputs(input, leaves));
+    return func(std::forward<Args>(args)...);
+  }
+};
+
+// Wraps func in a named profiler scope and keeps counters for it.
+template <class FuncType, FuncType func>
+FuncType profiled_kernel(const std::string& name) {
+  _profiled_kernel<FuncType, func>::name() = name;
+  return &_profiled_kernel<FuncType, func>::call;
+}
+
+// Registers the given kernel for NAME via m.impl_UNBOXED, wrapped such that
+// it shows up as NestedTensor_NAME in the profiler and in op_stats.
+#define NESTED_TENSOR_IMPL(NAME, ...)                                 \
+  m.impl_UNBOXED(                                                      \
+      NAME,                                                            \
+      torch::nested_tensor::                                           \
+          profiled_kernel<decltype(&__VA_ARGS__), __VA_ARGS__>(        \
+              "NestedTensor_" NAME))
+
+} // namespace nested_tensor
+} // namespace torch
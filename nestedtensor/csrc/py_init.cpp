@@ -1,8 +1,17 @@
+#include <nestedtensor/csrc/arena.h>
+#include <nestedtensor/csrc/batching.h>
 #include <nestedtensor/csrc/creation.h>
+#include <nestedtensor/csrc/jit_apply.h>
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/packed_sequence.h>
+#include <nestedtensor/csrc/profiling.h>
 #include <nestedtensor/csrc/utils/nested_node_functions.h>
 #include <nestedtensor/csrc/utils/python_nested_node.h>
+#include <nestedtensor/csrc/python_dispatch.h>
 #include <nestedtensor/csrc/python_functions.h>
+#include <nestedtensor/csrc/quantization.h>
+#include <nestedtensor/csrc/serialization.h>
+#include <nestedtensor/csrc/sorting.h>
 #include <torch/csrc/Size.h>
 #include <torch/extension.h>
 
@@ -21,26 +30,49 @@ using namespace torch::nested_tensor;
 using namespace at;
 
 
-py::object _nested_helper(c10::optional<int64_t> index, SizeNode&& size_node) {
-  auto fn = [](auto& self, const SizeNode& s, int64_t dim) -> py::object {
+py::object _nested_helper(int64_t index, const SizeTable& table) {
+  auto fn = [&table](
+                auto& self, int64_t level, int64_t node, int64_t dim)
+      -> py::object {
     if (dim == 0) {
-      return py::cast(s.degree());
+      return py::cast(table.degree(level, node));
     }
     // List of Tensors
-    if (s.height() == 1) {
+    if (level + 1 == table.nested_dim()) {
       std::vector<int64_t> result;
-      for (const auto& child : s.unbind()) {
-        result.push_back(child.payload().get(dim - 1));
+      for (int64_t i = table.child_begin(level, node);
+           i < table.child_end(level, node);
+           i++) {
+        result.push_back(table.get(i, dim - 1));
       }
       return py::tuple(py::cast(result));
     }
     std::vector<py::object> result;
-    for (const auto& child : s.unbind()) {
-      result.emplace_back(self(self, child, dim - 1));
+    for (int64_t i = table.child_begin(level, node);
+         i < table.child_end(level, node);
+         i++) {
+      result.emplace_back(self(self, level + 1, i, dim - 1));
     }
     return py::tuple(py::cast(result));
   };
-  return fn(fn, size_node, *index);
+  return fn(fn, 0, 0, index);
+}
+
+// Returns the entries of all constiuents as a single [num_leaves, tensor_dim]
+// int64 Tensor. For nested_dim > 1 the structure is returned alongside as a
+// list of offsets, one per nested level below the root. Level l holds
+// num_nodes + 1 entries and the children of its i-th node are the nodes
+// (or rows) offsets[l][i] to offsets[l][i + 1] of the next level.
+py::object _nested_tensor_helper(const SizeTable& table) {
+  at::Tensor entries = table.to_tensor();
+  if (table.nested_dim() <= 1) {
+    return py::cast(entries);
+  }
+  std::vector<at::Tensor> offsets;
+  for (int64_t level = 1; level < table.nested_dim(); level++) {
+    offsets.push_back(at::tensor(table.level_offsets(level)));
+  }
+  return py::make_tuple(entries, offsets);
 }
 
 
@@ -70,8 +102,8 @@ static auto registry =
             })
         .op("nestedtensor::requires_grad_",
             [](Tensor tensor, bool requires_grad) {
-              auto nt = get_nested_tensor_impl(tensor);
-              return nt->requires_grad_(requires_grad);
+              get_nested_tensor_impl(tensor)->requires_grad_(requires_grad);
+              return tensor;
             })
         .op("nestedtensor::backward",
             [](Tensor tensor,
@@ -93,6 +125,81 @@ static auto registry =
             [](Tensor tensor, c10::optional<int64_t> dim) {
               return NestedTensor_to_tensor(tensor, dim);
             })
+        .op("nestedtensor::to_dtype",
+            [](Tensor tensor, ScalarType dtype) {
+              return NestedTensor_to_dtype(tensor, dtype);
+            })
+        .op("nestedtensor::dropout",
+            [](Tensor tensor, double p) {
+              return NestedTensor_fused_dropout(tensor, p);
+            })
+        .op("nestedtensor::dropout_with_seed",
+            [](Tensor tensor, double p, int64_t seed) {
+              return NestedTensor_dropout_with_seed(tensor, p, seed);
+            })
+        .op("nestedtensor::dropout_mask",
+            [](Tensor tensor, double p, int64_t seed) {
+              return NestedTensor_dropout_mask(tensor, p, seed);
+            })
+        .op("nestedtensor::conv1d",
+            [](Tensor input,
+               Tensor weight,
+               c10::optional<Tensor> bias,
+               std::vector<int64_t> stride,
+               std::vector<int64_t> padding,
+               std::vector<int64_t> dilation,
+               int64_t groups,
+               std::string padding_mode) {
+              return NestedTensor_conv1d_padded(
+                  input,
+                  weight,
+                  bias,
+                  stride,
+                  padding,
+                  dilation,
+                  groups,
+                  padding_mode);
+            })
+        .op("nestedtensor::to_padded_tensor",
+            [](Tensor tensor, Scalar padding) {
+              return NestedTensor_to_padded_tensor(tensor, padding);
+            })
+        .op("nestedtensor::quantize",
+            [](Tensor tensor, bool per_row) {
+              return quantize_nested_tensor(tensor, per_row);
+            })
+        .op("nestedtensor::dequantize",
+            [](Tensor data,
+               Tensor scale,
+               Tensor zero_point,
+               bool per_row,
+               ScalarType dtype) {
+              return dequantize_nested_tensor(
+                  data, scale, zero_point, per_row, dtype);
+            })
+        .op("nestedtensor::quantized_matmul",
+            [](Tensor data,
+               Tensor scale,
+               Tensor zero_point,
+               bool per_row,
+               Tensor weight) {
+              return quantized_matmul(data, scale, zero_point, per_row, weight);
+            })
+        .op("nestedtensor::arena_stats",
+            []() {
+              ArenaStats stats = arena_stats();
+              c10::Dict<std::string, int64_t> result;
+              result.insert("bytes_reserved", stats.bytes_reserved);
+              result.insert("blocks_reserved", stats.blocks_reserved);
+              result.insert("bytes_reused", stats.bytes_reused);
+              result.insert("blocks_reused", stats.blocks_reused);
+              result.insert("bytes_cached", stats.bytes_cached);
+              return result;
+            })
+        .op("nestedtensor::arena_reset_stats", []() { arena_reset_stats(); })
+        .op("nestedtensor::arena_empty_cache", []() { arena_empty_cache(); })
+        .op("nestedtensor::stats", []() { return op_stats(); })
+        .op("nestedtensor::reset_stats", []() { reset_op_stats(); })
         .op("nestedtensor::str", [](Tensor tensor) {
           auto node = get_nested_tensor_structure(tensor);
           return NestedNode___str__(
@@ -126,57 +233,163 @@ PYBIND11_MODULE(TORCH_EXTENSION_NAME, m) {
 
   m.def("nested_tensor_impl", &torch::nested_tensor::nested_tensor_impl);
 
+  py::class_<NestedTensorBuilder>(m, "NestedTensorBuilder")
+      .def(py::init<>())
+      .def("reserve", &NestedTensorBuilder::reserve)
+      .def("append", &NestedTensorBuilder::append)
+      .def("finish", &NestedTensorBuilder::finish)
+      .def("__len__", &NestedTensorBuilder::len);
+
+  // NOTE: Waiting for requests or results doesn't need the GIL, which the
+  // threads that submit requests or complete batches do need.
+  py::class_<BatchedRequest>(m, "BatchedRequest")
+      .def("done", &BatchedRequest::done)
+      .def(
+          "wait",
+          &BatchedRequest::wait,
+          py::arg("timeout_ms") = c10::nullopt,
+          py::call_guard<py::gil_scoped_release>());
+
+  py::class_<DynamicBatch, std::shared_ptr<DynamicBatch>>(m, "DynamicBatch")
+      .def("input", &DynamicBatch::input)
+      .def("complete", &DynamicBatch::complete)
+      .def("fail", &DynamicBatch::fail)
+      .def("__len__", &DynamicBatch::size);
+
+  py::class_<DynamicBatcher>(m, "DynamicBatcher")
+      .def(
+          py::init<int64_t, double, c10::optional<int64_t>>(),
+          py::arg("max_tokens"),
+          py::arg("max_latency_ms"),
+          py::arg("max_batch_size") = c10::nullopt)
+      .def("submit", &DynamicBatcher::submit)
+      .def(
+          "next_batch",
+          &DynamicBatcher::next_batch,
+          py::arg("timeout_ms") = c10::nullopt,
+          py::call_guard<py::gil_scoped_release>())
+      .def("close", &DynamicBatcher::close)
+      .def("closed", &DynamicBatcher::closed)
+      .def("pending", &DynamicBatcher::pending);
+
   // Need to overwrite because
   // https://github.com/pytorch/pytorch/blob/09660896c0dd2bec888857300a7be9edb52dd05d/aten/src/ATen/TensorIndexing.h#L480
   // requires sizes() for non Tensor-shape compliant NestedTensors
   // and can't be overwritten since it's not a native function.
-  // TODO: Advanced indexing
   // TODO: Tensor-wise select
   // TODO: Tuple support
-  m.def("get_item", [](Tensor tensor, int64_t key_) {
-    std::vector<at::Tensor> unbound = unbind(tensor, 0);
-    int64_t key = at::maybe_wrap_dim(key_, unbound.size());
-    return unbind(tensor, 0)[key];
+  // NOTE: Registered first, so that one element Tensors aren't
+  // converted to an int.
+  m.def("get_item", [](Tensor tensor, Tensor key) {
+    return at::index_select(tensor, 0, key);
+  });
+  m.def("get_item", [](Tensor tensor, int64_t key) {
+    return at::select(tensor, 0, key);
   });
 #if (PYBIND11_VERSION_MAJOR == 2 && PYBIND11_VERSION_MINOR >= 4)
+  // NOTE: Returns a NestedTensor that shares its constiuents with tensor.
   m.def("get_item", [](Tensor tensor, py::slice key) {
-    py::list unbound = py::cast(unbind(tensor, 0));
-    return unbound[key];
+    size_t start, stop, step, slicelength;
+    if (!key.compute(
+            get_nested_tensor_structure(tensor).degree(),
+            &start,
+            &stop,
+            &step,
+            &slicelength)) {
+      throw py::error_already_set();
+    }
+    TORCH_CHECK(
+        int64_t(step) > 0, "NestedTensor slicing requires a positive step.");
+    return at::slice(tensor, 0, start, start + slicelength * step, step);
   });
 #endif
 
   m.def("nested_size", [](Tensor self, c10::optional<int64_t> index_) {
     auto nt = get_nested_tensor_impl(self);
+    auto nested_size = nt->nested_size();
+    const SizeTable& table = *nested_size;
     if (!index_) {
       return py::cast(THPPythonNode(
-          map(
-              [](c10::List<int64_t> e) {
-                std::vector<int64_t> e_vec = e.vec();
+          table_map(
+              table,
+              [&table](int64_t leaf) {
+                std::vector<int64_t> e_vec = table.get(leaf);
                 return py::reinterpret_steal<py::object>(
                     THPSize_NewFromSizes(e_vec.size(), e_vec.data()));
-              },
-              nt->nested_size()),
+              }),
           "NestedSize"));
     }
     int64_t index = at::maybe_wrap_dim((*index_), nt->dim());
-    SizeNode size_node = nt->nested_size();
-    return _nested_helper(index, std::move(size_node));
+    return _nested_helper(index, table);
+  });
+
+  m.def("nested_size_tensor", [](Tensor self) {
+    return _nested_tensor_helper(*get_nested_tensor_impl(self)->nested_size());
+  });
+
+  m.def("nested_stride_tensor", [](Tensor self) {
+    return _nested_tensor_helper(
+        get_nested_tensor_impl(self)->nested_stride());
   });
 
   m.def("nested_stride", [](Tensor self, c10::optional<int64_t> index_) {
     auto nt = get_nested_tensor_impl(self);
+    SizeTable table = nt->nested_stride();
     if (!index_) {
       return py::cast(THPPythonNode(
-          map([](c10::List<int64_t> e)
-                  -> py::object { return py::tuple(py::cast(e.vec())); },
-              nt->nested_stride()),
+          table_map(
+              table,
+              [&table](int64_t leaf) -> py::object {
+                return py::tuple(py::cast(table.get(leaf)));
+              }),
           "NestedStride"));
     }
     int64_t index = at::maybe_wrap_dim((*index_), nt->dim());
-    SizeNode size_node = nt->nested_stride();
-    return _nested_helper(index, std::move(size_node));
+    return _nested_helper(index, table);
   });
 
+  m.def(
+      "jit_apply",
+      [](py::object fn, Tensor self, bool batch) {
+        auto function = py::cast<torch::jit::StrongFunctionPtr>(fn);
+        // NOTE: Scripted functions don't need the GIL and constiuents run
+        // on other threads while this one waits.
+        py::gil_scoped_release release;
+        return torch::nested_tensor::jit_apply(
+            *function.function_, self, batch);
+      },
+      py::arg("fn"),
+      py::arg("self"),
+      py::arg("batch") = false);
+
+  m.def(
+      "sort_by_size",
+      &torch::nested_tensor::sort_by_size,
+      py::arg("self"),
+      py::arg("dim"),
+      py::arg("descending") = false);
+  m.def(
+      "bucketize_by_size",
+      &torch::nested_tensor::bucketize_by_size,
+      py::arg("self"),
+      py::arg("dim"),
+      py::arg("boundaries"));
+
+  m.def(
+      "to_packed_sequence",
+      &torch::nested_tensor::nested_tensor_to_packed_sequence);
+  m.def(
+      "from_packed_sequence",
+      &torch::nested_tensor::nested_tensor_from_packed_sequence,
+      py::arg("data"),
+      py::arg("batch_sizes"),
+      py::arg("sorted_indices") = c10::nullopt,
+      py::arg("unsorted_indices") = c10::nullopt);
+
+  m.def("save_nested_tensor", &torch::nested_tensor::save_nested_tensor);
+  m.def("load_nested_tensor", &torch::nested_tensor::load_nested_tensor);
+
   add_functions(m);
+  add_dispatch(m);
 }
 
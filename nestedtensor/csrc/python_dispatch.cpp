@@ -0,0 +1,97 @@
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/python_dispatch.h>
+#include <torch/csrc/autograd/python_variable.h>
+
+namespace py = pybind11;
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+// NOTE: Intentionally leaked. The class must stay valid for as long as
+// the interpreter, which outlives static destruction of this library.
+py::object& _nested_tensor_class() {
+  static py::object* cls = new py::object();
+  return *cls;
+}
+
+bool _is_nested_tensor(py::handle obj) {
+  return _nested_tensor_class() &&
+      PyObject_IsInstance(obj.ptr(), _nested_tensor_class().ptr()) == 1;
+}
+
+py::object _unwrap(py::handle obj) {
+  if (_is_nested_tensor(obj)) {
+    return obj.attr("_impl");
+  }
+  return py::reinterpret_borrow<py::object>(obj);
+}
+
+py::object _wrap_result(py::object result) {
+  if (!THPVariable_Check(result.ptr())) {
+    return result;
+  }
+  const at::Tensor& tensor =
+      reinterpret_cast<THPVariable*>(result.ptr())->cdata;
+  if (!at::is_nested_tensor_impl(tensor)) {
+    return result;
+  }
+  // NOTE: Skips NestedTensor.__init__, which only verifies that result is
+  // a NestedTensorImpl again.
+  py::object cls = _nested_tensor_class();
+  py::object wrapped = cls.attr("__new__")(cls);
+  py::setattr(wrapped, "_impl", result);
+  return wrapped;
+}
+
+py::tuple _unwrap_args(py::tuple args, size_t start = 0) {
+  py::tuple result(args.size() - start);
+  for (size_t i = start; i < args.size(); i++) {
+    result[i - start] = _unwrap(args[i]);
+  }
+  return result;
+}
+
+py::dict _unwrap_kwargs(py::object kwargs) {
+  py::dict result;
+  if (kwargs.is_none()) {
+    return result;
+  }
+  for (auto item : py::reinterpret_borrow<py::dict>(kwargs)) {
+    result[item.first] = _unwrap(item.second);
+  }
+  return result;
+}
+
+} // namespace
+
+void add_dispatch(pybind11::module m) {
+  m.def("_register_nested_tensor_class", [](py::object cls) {
+    _nested_tensor_class() = cls;
+  });
+  m.def("_wrap_result", &_wrap_result);
+  m.def("_filter_impl", [](py::tuple args, py::object kwargs) {
+    return py::make_tuple(py::list(_unwrap_args(args)), _unwrap_kwargs(kwargs));
+  });
+  // Calls method name of the impl of args[0] with the remaining arguments.
+  m.def(
+      "_call_method",
+      [](const std::string& name, py::tuple args, py::object kwargs) {
+        TORCH_CHECK(args.size() > 0, "Expected at least one argument.");
+        py::object self = _unwrap(args[0]);
+        py::object result = self.attr(name.c_str())(
+            *_unwrap_args(args, 1), **_unwrap_kwargs(kwargs));
+        return _wrap_result(result);
+      });
+  // Calls func with the impls of all arguments. Used by __torch_function__.
+  m.def(
+      "_call_function",
+      [](py::object func, py::tuple args, py::object kwargs) {
+        py::object result = func(*_unwrap_args(args), **_unwrap_kwargs(kwargs));
+        return _wrap_result(result);
+      });
+}
+
+} // namespace nested_tensor
+} // namespace torch
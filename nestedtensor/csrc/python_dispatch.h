@@ -0,0 +1,12 @@
+#pragma once
+#include <torch/extension.h>
+
+// Fast paths for the Python NestedTensor wrapper in nested/nested.py.
+// Unwrapping the arguments, calling the underlying impl and wrapping the
+// result happens here in one go instead of in a handful of Python frames.
+
+namespace torch {
+namespace nested_tensor {
+void add_dispatch(pybind11::module);
+} // namespace nested_tensor
+} // namespace torch
@@ -1,6 +1,7 @@
 #include <nestedtensor/csrc/python_args.h>	
 #include <nestedtensor/csrc/python_functions.h>	
 #include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
 #include <pybind11/stl.h>	
 #include <torch/extension.h>	
 
@@ -71,9 +72,9 @@ NestedTensor interpolate(NestedTensor& input,
     // Either scale factor or size can be passed
     if (scale_factor.has_value()) {
       options = options.scale_factor(scale_factor.value().vec());
-      TensorNode res = map(
+      TensorNode res = batched_map(
         [&options](at::Tensor input_tensor) {
-          return F::interpolate(input_tensor.unsqueeze(0), options).squeeze(0);
+          return F::interpolate(input_tensor, options);
         },
         input_structure);
       return NestedTensor(std::move(res));
@@ -92,10 +93,10 @@ NestedTensor interpolate(NestedTensor& input,
       }
 
       if (size.value().size() == 1) {
-        TensorNode res = map(
-          [&options, &size](at::Tensor input_tensor) {
-            options = options.size(size.value()[0]);
-            return F::interpolate(input_tensor.unsqueeze(0), options).squeeze(0);
+        options = options.size(size.value()[0]);
+        TensorNode res = batched_map(
+          [&options](at::Tensor input_tensor) {
+            return F::interpolate(input_tensor, options);
           },
           input_structure);
         return NestedTensor(std::move(res));
@@ -126,7 +127,7 @@ void add_functions(pybind11::module m) {
          c10::optional<std::string> mode,
          c10::optional<bool> align_corners,
          c10::optional<bool> recompute_scale_factor) {
-        auto input = get_nested_tensor_impl(input_)->_data;
+        auto input = get_nested_tensor_impl(input_)->data();
         if (scale_factor.has_value() && size.has_value()) {
           throw std::runtime_error(
               "only one of size or scale_factor should be defined");
@@ -163,7 +164,7 @@ void add_functions(pybind11::module m) {
          c10::optional<std::string> mode,
          c10::optional<bool> align_corners,
          c10::optional<bool> recompute_scale_factor) {
-        auto input = get_nested_tensor_impl(input_)->_data;
+        auto input = get_nested_tensor_impl(input_)->data();
         if (scale_factor.has_value() && size.has_value()) {
           throw std::runtime_error(
               "only one of size or scale_factor should be defined");
@@ -201,7 +202,7 @@ void add_functions(pybind11::module m) {
          c10::optional<std::string> mode,
          c10::optional<bool> align_corners,
          c10::optional<bool> recompute_scale_factor) {
-        auto input = get_nested_tensor_impl(input_)->_data;
+        auto input = get_nested_tensor_impl(input_)->data();
         if (scale_factor.has_value() && size.has_value()) {
           throw std::runtime_error(
               "only one of size or scale_factor should be defined");
@@ -242,8 +243,8 @@ void add_functions(pybind11::module m) {
          c10::optional<int64_t> ignore_index,
          c10::optional<bool> reduce, // TODO: use
          c10::optional<std::string> reduction) {
-        auto input = get_nested_tensor_impl(input_)->_data;
-        auto target = get_nested_tensor_impl(target_)->_data;
+        auto input = get_nested_tensor_impl(input_)->data();
+        auto target = get_nested_tensor_impl(target_)->data();
         return at::detail::make_tensor<NestedTensorImpl>(cross_entropy(
             input,
             target,
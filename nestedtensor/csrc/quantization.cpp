@@ -0,0 +1,331 @@
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <nestedtensor/csrc/arena.h>
+#include <nestedtensor/csrc/quantization.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+constexpr int64_t kQMin = -128;
+constexpr int64_t kQMax = 127;
+// Rows of int8 data widened to float at a time by quantized_matmul.
+constexpr int64_t kRowBlock = 256;
+
+std::vector<at::Tensor> _contiguous_leaves(const at::Tensor& tensor) {
+  TORCH_CHECK(
+      tensor.device().is_cpu(),
+      "Quantized NestedTensors are only supported on CPU.");
+  std::vector<at::Tensor> leaves;
+  for (at::Tensor leaf : flatten(at::get_nested_tensor_structure(tensor))) {
+    leaves.push_back(leaf.detach().contiguous());
+  }
+  return leaves;
+}
+
+// Number of slices along the last dimension.
+int64_t _num_rows(const at::Tensor& leaf) {
+  if (leaf.dim() == 0) {
+    return 1;
+  }
+  int64_t row_size = leaf.size(-1);
+  return row_size == 0 ? 0 : leaf.numel() / row_size;
+}
+
+// Index of the first group of each constiuent followed by the total number
+// of groups.
+std::vector<int64_t> _group_offsets(
+    const std::vector<at::Tensor>& leaves,
+    bool per_row) {
+  std::vector<int64_t> offsets(1, 0);
+  for (const auto& leaf : leaves) {
+    offsets.push_back(offsets.back() + (per_row ? _num_rows(leaf) : 1));
+  }
+  return offsets;
+}
+
+std::vector<int64_t> _checked_group_offsets(
+    const std::vector<at::Tensor>& leaves,
+    const at::Tensor& scale,
+    const at::Tensor& zero_point,
+    bool per_row) {
+  TORCH_CHECK(
+      scale.dim() == 1 && zero_point.dim() == 1 &&
+          scale.numel() == zero_point.numel(),
+      "Expected scale and zero_point to be 1-dimensional and of equal size.");
+  std::vector<int64_t> offsets = _group_offsets(leaves, per_row);
+  TORCH_CHECK(
+      scale.numel() == offsets.back(),
+      "Expected one scale per ",
+      per_row ? "row" : "constiuent",
+      ", i.e. ",
+      offsets.back(),
+      ", but got ",
+      scale.numel(),
+      ".");
+  return offsets;
+}
+
+void _check_quantized(const std::vector<at::Tensor>& leaves) {
+  for (const auto& leaf : leaves) {
+    TORCH_CHECK(
+        leaf.scalar_type() == at::kChar,
+        "Expected quantized int8 data, but got ",
+        leaf.scalar_type(),
+        ".");
+  }
+}
+
+// Picks scale and zero point such that the range of the group, extended to
+// include 0, maps onto [kQMin, kQMax], and quantizes it.
+template <typename scalar_t>
+void _quantize_group(
+    const scalar_t* input,
+    int8_t* output,
+    int64_t numel,
+    float& scale,
+    int64_t& zero_point) {
+  float min = 0;
+  float max = 0;
+  for (int64_t i = 0; i < numel; i++) {
+    float value = static_cast<float>(input[i]);
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  scale = (max - min) / (kQMax - kQMin);
+  if (scale == 0) {
+    scale = 1;
+  }
+  zero_point = std::min(
+      kQMax, std::max(kQMin, kQMin - int64_t(std::nearbyint(min / scale))));
+  float inv_scale = 1 / scale;
+  for (int64_t i = 0; i < numel; i++) {
+    int64_t q = int64_t(std::nearbyint(static_cast<float>(input[i]) * inv_scale)) +
+        zero_point;
+    output[i] = static_cast<int8_t>(std::min(kQMax, std::max(kQMin, q)));
+  }
+}
+
+// Packs the given constiuent sizes into a single buffer.
+NestedTensor _packed_like(
+    const at::Tensor& tensor,
+    const std::vector<std::vector<int64_t>>& sizes,
+    const at::TensorOptions& options) {
+  int64_t numel = 0;
+  for (const auto& size : sizes) {
+    numel += std::accumulate(
+        size.begin(), size.end(), int64_t(1), std::multiplies<int64_t>());
+  }
+  at::Tensor buffer = arena_empty(numel, options);
+  int64_t offset = 0;
+  size_t index = 0;
+  TensorNode structure = map(
+      [&buffer, &offset, &index, &sizes](at::Tensor) {
+        const auto& size = sizes[index++];
+        int64_t leaf_numel = std::accumulate(
+            size.begin(), size.end(), int64_t(1), std::multiplies<int64_t>());
+        at::Tensor view = buffer.narrow(0, offset, leaf_numel).view(size);
+        offset += leaf_numel;
+        return view;
+      },
+      at::get_nested_tensor_structure(tensor));
+  return NestedTensor(std::move(buffer), std::move(structure));
+}
+
+} // namespace
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> quantize_nested_tensor(
+    const at::Tensor& tensor,
+    bool per_row) {
+  std::vector<at::Tensor> leaves = _contiguous_leaves(tensor);
+  TORCH_CHECK(
+      at::isFloatingType(tensor.scalar_type()),
+      "Can only quantize floating point NestedTensors, but got ",
+      tensor.scalar_type(),
+      ".");
+  std::vector<int64_t> group_offsets = _group_offsets(leaves, per_row);
+  at::Tensor scale = at::empty({group_offsets.back()}, at::kFloat);
+  at::Tensor zero_point = at::empty({group_offsets.back()}, at::kLong);
+  NestedTensor data = arena_empty_like(
+      at::get_nested_tensor_structure(tensor),
+      at::TensorOptions().dtype(at::kChar));
+  c10::List<at::Tensor> outputs = flatten(data.get_structure());
+  float* scale_data = scale.data_ptr<float>();
+  int64_t* zero_point_data = zero_point.data_ptr<int64_t>();
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::Half,
+      at::ScalarType::BFloat16,
+      tensor.scalar_type(),
+      "quantize_nested_tensor",
+      [&] {
+        at::parallel_for(0, leaves.size(), 1, [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; i++) {
+            const scalar_t* input = leaves[i].data_ptr<scalar_t>();
+            int8_t* output = outputs.get(i).data_ptr<int8_t>();
+            int64_t groups = group_offsets[i + 1] - group_offsets[i];
+            int64_t group_numel = groups == 0 ? 0 : leaves[i].numel() / groups;
+            for (int64_t g = 0; g < groups; g++) {
+              int64_t index = group_offsets[i] + g;
+              _quantize_group(
+                  input + g * group_numel,
+                  output + g * group_numel,
+                  group_numel,
+                  scale_data[index],
+                  zero_point_data[index]);
+            }
+          }
+        });
+      });
+  return std::make_tuple(
+      at::wrap_nested_tensor(std::move(data)), scale, zero_point);
+}
+
+at::Tensor dequantize_nested_tensor(
+    const at::Tensor& data,
+    const at::Tensor& scale_,
+    const at::Tensor& zero_point_,
+    bool per_row,
+    at::ScalarType dtype) {
+  std::vector<at::Tensor> leaves = _contiguous_leaves(data);
+  _check_quantized(leaves);
+  std::vector<int64_t> group_offsets =
+      _checked_group_offsets(leaves, scale_, zero_point_, per_row);
+  at::Tensor scale = scale_.to(at::kFloat).contiguous();
+  at::Tensor zero_point = zero_point_.to(at::kLong).contiguous();
+  NestedTensor result = arena_empty_like(
+      at::get_nested_tensor_structure(data),
+      at::TensorOptions().dtype(dtype));
+  c10::List<at::Tensor> outputs = flatten(result.get_structure());
+  const float* scale_data = scale.data_ptr<float>();
+  const int64_t* zero_point_data = zero_point.data_ptr<int64_t>();
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::Half,
+      at::ScalarType::BFloat16,
+      dtype,
+      "dequantize_nested_tensor",
+      [&] {
+        at::parallel_for(0, leaves.size(), 1, [&](int64_t begin, int64_t end) {
+          for (int64_t i = begin; i < end; i++) {
+            const int8_t* input = leaves[i].data_ptr<int8_t>();
+            scalar_t* output = outputs.get(i).data_ptr<scalar_t>();
+            int64_t groups = group_offsets[i + 1] - group_offsets[i];
+            int64_t group_numel = groups == 0 ? 0 : leaves[i].numel() / groups;
+            for (int64_t g = 0; g < groups; g++) {
+              float group_scale = scale_data[group_offsets[i] + g];
+              float group_zero_point = zero_point_data[group_offsets[i] + g];
+              for (int64_t j = g * group_numel; j < (g + 1) * group_numel;
+                   j++) {
+                output[j] = static_cast<scalar_t>(
+                    group_scale *
+                    (static_cast<float>(input[j]) - group_zero_point));
+              }
+            }
+          }
+        });
+      });
+  return at::wrap_nested_tensor(std::move(result));
+}
+
+at::Tensor quantized_matmul(
+    const at::Tensor& data,
+    const at::Tensor& scale_,
+    const at::Tensor& zero_point_,
+    bool per_row,
+    const at::Tensor& weight_) {
+  std::vector<at::Tensor> leaves = _contiguous_leaves(data);
+  _check_quantized(leaves);
+  _checked_group_offsets(leaves, scale_, zero_point_, per_row);
+  TORCH_CHECK(
+      weight_.dim() == 2, "Expected a 2-dimensional weight for matmul.");
+  int64_t k = weight_.size(0);
+  int64_t m = weight_.size(1);
+  std::vector<std::vector<int64_t>> sizes;
+  // Index of the first row of each constiuent followed by the total.
+  std::vector<int64_t> row_offsets(1, 0);
+  for (const auto& leaf : leaves) {
+    TORCH_CHECK(
+        leaf.dim() > 0 && leaf.size(-1) == k,
+        "Size mismatch for matmul of constiuent of size ",
+        leaf.sizes(),
+        " with weight of size ",
+        weight_.sizes(),
+        ".");
+    std::vector<int64_t> size = leaf.sizes().vec();
+    size.back() = m;
+    sizes.push_back(size);
+    row_offsets.push_back(row_offsets.back() + _num_rows(leaf));
+  }
+  at::Tensor scale = scale_.to(at::kFloat).contiguous();
+  at::Tensor zero_point = zero_point_.to(at::kLong).contiguous();
+  at::Tensor weight = weight_.detach().to(at::kFloat).contiguous();
+  // Folds the zero points into the result: for a row q with scale s and
+  // zero point z, s * (q - z) @ W = s * (q @ W - z * W.sum(0)).
+  at::Tensor weight_sum = weight.sum(0);
+  NestedTensor result =
+      _packed_like(data, sizes, at::TensorOptions().dtype(at::kFloat));
+  int64_t num_rows = row_offsets.back();
+  // The constiuents are packed back-to-back, so the result is a single
+  // [rows, m] matrix.
+  at::Tensor output = result.get_buffer()->view({num_rows, m});
+  std::vector<const int8_t*> input_data;
+  for (size_t i = 0; i < leaves.size(); i++) {
+    input_data.push_back(leaves[i].data_ptr<int8_t>());
+  }
+
+  // NOTE: ATen has no int8 GEMM to call here. Instead each block of rows is
+  // widened to float as is, i.e. without its scale and zero point, and
+  // multiplied with the weight in a single at::mm. Only one block is ever
+  // held in float.
+  at::Tensor block =
+      at::empty({std::min(num_rows, kRowBlock), k}, at::kFloat);
+  size_t leaf_index = 0;
+  for (int64_t begin = 0; begin < num_rows; begin += kRowBlock) {
+    int64_t rows = std::min(kRowBlock, num_rows - begin);
+    float* block_data = block.data_ptr<float>();
+    for (int64_t row = begin; row < begin + rows; row++) {
+      while (row >= row_offsets[leaf_index + 1]) {
+        leaf_index++;
+      }
+      const int8_t* input =
+          input_data[leaf_index] + (row - row_offsets[leaf_index]) * k;
+      std::copy(input, input + k, block_data + (row - begin) * k);
+    }
+    at::Tensor output_block = output.narrow(0, begin, rows);
+    at::mm_out(output_block, block.narrow(0, 0, rows), weight);
+  }
+
+  const float* scale_data = scale.data_ptr<float>();
+  const int64_t* zero_point_data = zero_point.data_ptr<int64_t>();
+  const float* weight_sum_data = weight_sum.data_ptr<float>();
+  float* output_data = output.data_ptr<float>();
+  int64_t grain_size =
+      std::max(int64_t(1), at::internal::GRAIN_SIZE / std::max(int64_t(1), m));
+  at::parallel_for(0, num_rows, grain_size, [&](int64_t begin, int64_t end) {
+    size_t i =
+        std::upper_bound(row_offsets.begin(), row_offsets.end(), begin) -
+        row_offsets.begin() - 1;
+    for (int64_t row = begin; row < end; row++) {
+      while (row >= row_offsets[i + 1]) {
+        i++;
+      }
+      int64_t group = per_row ? row : int64_t(i);
+      float group_scale = scale_data[group];
+      float group_zero_point = zero_point_data[group];
+      float* output_row = output_data + row * m;
+      for (int64_t j = 0; j < m; j++) {
+        output_row[j] = group_scale *
+            (output_row[j] - group_zero_point * weight_sum_data[j]);
+      }
+    }
+  });
+  return at::wrap_nested_tensor(std::move(result));
+}
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,44 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// Affine int8 quantization of NestedTensors for inference. The quantized
+// data is a NestedTensor of int8 constiuents packed into a single buffer.
+// Each group of elements, i.e. either a whole constiuent or a row (a slice
+// along the last dimension) of a constiuent, has its own scale and zero
+// point, such that x = scale * (q - zero_point).
+//
+// scale (float) and zero_point (int64) are flat Tensors with one entry per
+// group, in the order of the constiuents. per_row selects between groups
+// per row and per constiuent and has to match what the data was quantized
+// with, since the number of entries alone can be the same for both.
+
+// Quantizes all constiuents in a single pass over each group. Returns the
+// int8 data, scale and zero_point.
+std::tuple<at::Tensor, at::Tensor, at::Tensor> quantize_nested_tensor(
+    const at::Tensor& tensor,
+    bool per_row);
+
+// Dequantizes into a packed NestedTensor of the given dtype.
+at::Tensor dequantize_nested_tensor(
+    const at::Tensor& data,
+    const at::Tensor& scale,
+    const at::Tensor& zero_point,
+    bool per_row,
+    at::ScalarType dtype);
+
+// Multiplies each quantized constiuent with the dense 2-dimensional float
+// weight. The int8 data is read straight from the packed buffer and
+// dequantized inside the kernel, so no float copy of it is materialized.
+// The result is a packed float NestedTensor.
+at::Tensor quantized_matmul(
+    const at::Tensor& data,
+    const at::Tensor& scale,
+    const at::Tensor& zero_point,
+    bool per_row,
+    const at::Tensor& weight);
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,416 @@
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/WrapDimUtils.h>
+#include <nestedtensor/csrc/arena.h>
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+#include <nestedtensor/csrc/profiling.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <torch/csrc/autograd/custom_function.h>
+#include <torch/library.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace at {
+
+using namespace torch::nested_tensor;
+
+// NOTE: Scans along a tensor dimension restart at the boundary of every
+// constiuent. All constiuents are laid out back-to-back in a flat Tensor and
+// the scan runs over the lines, i.e. the 1-dimensional slices along dim.
+// For each index into the dimensions before dim the lines of a constiuent
+// form a panel of contiguous rows, which are scanned together one row at a
+// time, so that the accesses stay contiguous even though the elements of a
+// single line are strided. The rows of all panels are concatenated into one
+// sequence, which is split into one chunk per thread. Each chunk is scanned
+// on its own and the carry of the panel that spans into the next chunk is
+// applied afterwards, which is work-efficient no matter whether there are
+// many short panels or a few long ones.
+
+enum class ScanOp : int64_t { Sum = 0, Prod = 1, LogSumExp = 2 };
+
+// Panels as an int64 Tensor of size [number of panels + 1, 3]. Row p holds
+// the start of panel p in the sequence of rows, the index of its first
+// element in the flat Tensor and its width, i.e. the number of lines. The
+// last row holds the total number of rows.
+Tensor _scan_plan(const SizeTable& table, int64_t dim) {
+  std::vector<int64_t> plan;
+  int64_t start = 0;
+  int64_t offset = 0;
+  for (int64_t leaf = 0; leaf < table.num_leaves(); leaf++) {
+    std::vector<int64_t> size = table.get(leaf);
+    int64_t outer = 1;
+    int64_t inner = 1;
+    for (int64_t i = 0; i < dim; i++) {
+      outer *= size[i];
+    }
+    for (int64_t i = dim + 1; i < int64_t(size.size()); i++) {
+      inner *= size[i];
+    }
+    int64_t length = size[dim];
+    for (int64_t o = 0; length > 0 && inner > 0 && o < outer; o++) {
+      plan.insert(plan.end(), {start, offset + o * length * inner, inner});
+      start += length;
+    }
+    offset += outer * length * inner;
+  }
+  plan.insert(plan.end(), {start, 0, 0});
+  return at::tensor(plan, kLong).view({-1, 3});
+}
+
+template <class acc_t, ScanOp op>
+struct ScanCombine {
+  static acc_t identity() {
+    switch (op) {
+      case ScanOp::Sum:
+        return acc_t(0);
+      case ScanOp::Prod:
+        return acc_t(1);
+      default:
+        return -std::numeric_limits<acc_t>::infinity();
+    }
+  }
+  static acc_t apply(acc_t a, acc_t b) {
+    switch (op) {
+      case ScanOp::Sum:
+        return a + b;
+      case ScanOp::Prod:
+        return a * b;
+      default:
+        acc_t max = std::max(a, b);
+        if (max == -std::numeric_limits<acc_t>::infinity()) {
+          return max;
+        }
+        return max + std::log1p(std::exp(std::min(a, b) - max));
+    }
+  }
+};
+
+template <class scalar_t, ScanOp op>
+void _scan_panels(
+    scalar_t* output_data,
+    const scalar_t* input_data,
+    const int64_t* plan_data,
+    int64_t num_panels,
+    bool reverse) {
+  using acc_t = at::acc_type<scalar_t, false>;
+  using Combine = ScanCombine<acc_t, op>;
+  // Panels are never empty, so their starts are strictly increasing.
+  int64_t num_rows = plan_data[3 * num_panels];
+  if (num_rows == 0) {
+    return;
+  }
+  auto panel_start = [plan_data](int64_t panel) {
+    return plan_data[3 * panel];
+  };
+  auto width = [plan_data](int64_t panel) { return plan_data[3 * panel + 2]; };
+  // Index into input and output of the first element of row v of the
+  // sequence, which lies in the given panel.
+  auto row = [&](int64_t panel, int64_t v) {
+    int64_t pos = v - panel_start(panel);
+    if (reverse) {
+      pos = panel_start(panel + 1) - panel_start(panel) - 1 - pos;
+    }
+    return plan_data[3 * panel + 1] + pos * width(panel);
+  };
+  auto panel_of = [&](int64_t v) {
+    int64_t panel = 0;
+    int64_t end = num_panels;
+    while (panel + 1 < end) {
+      int64_t mid = (panel + end) / 2;
+      if (panel_start(mid) <= v) {
+        panel = mid;
+      } else {
+        end = mid;
+      }
+    }
+    return panel;
+  };
+  int64_t numel = 0;
+  for (int64_t panel = 0; panel < num_panels; panel++) {
+    numel += (panel_start(panel + 1) - panel_start(panel)) * width(panel);
+  }
+  int64_t num_chunks = std::max(
+      int64_t(1),
+      std::min(
+          std::min(int64_t(at::get_num_threads()), num_rows),
+          numel / at::internal::GRAIN_SIZE));
+  int64_t chunk_rows = (num_rows + num_chunks - 1) / num_chunks;
+
+  // Scan of the last panel of each chunk up to the end of the chunk and
+  // whether that panel starts within the chunk.
+  std::vector<std::vector<acc_t>> carries(num_chunks);
+  std::vector<char> restarts(num_chunks, 0);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t v = c * chunk_rows;
+      int64_t v_end = std::min(num_rows, v + chunk_rows);
+      if (v >= v_end) {
+        continue;
+      }
+      int64_t panel = panel_of(v);
+      restarts[c] = panel_start(panel) == v;
+      std::vector<acc_t> acc(width(panel), Combine::identity());
+      for (; v < v_end; v++) {
+        if (v == panel_start(panel + 1)) {
+          panel++;
+          acc.assign(width(panel), Combine::identity());
+          restarts[c] = 1;
+        }
+        int64_t i = row(panel, v);
+        for (int64_t k = 0; k < width(panel); k++) {
+          acc[k] =
+              Combine::apply(acc[k], static_cast<acc_t>(input_data[i + k]));
+          output_data[i + k] = static_cast<scalar_t>(acc[k]);
+        }
+      }
+      carries[c] = std::move(acc);
+    }
+  });
+  // Carry into each chunk from the panel it starts in the middle of. That
+  // panel is the last one of the previous chunk.
+  std::vector<std::vector<acc_t>> carry_in(num_chunks);
+  for (int64_t c = 1; c < num_chunks && c * chunk_rows < num_rows; c++) {
+    carry_in[c] = carries[c - 1];
+    if (!restarts[c - 1]) {
+      for (size_t k = 0; k < carry_in[c].size(); k++) {
+        carry_in[c][k] = Combine::apply(carry_in[c - 1][k], carry_in[c][k]);
+      }
+    }
+  }
+  at::parallel_for(1, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t v = c * chunk_rows;
+      int64_t v_end = std::min(num_rows, v + chunk_rows);
+      if (v >= v_end) {
+        continue;
+      }
+      int64_t panel = panel_of(v);
+      if (panel_start(panel) == v) {
+        continue;
+      }
+      v_end = std::min(v_end, panel_start(panel + 1));
+      for (; v < v_end; v++) {
+        int64_t i = row(panel, v);
+        for (int64_t k = 0; k < width(panel); k++) {
+          output_data[i + k] = static_cast<scalar_t>(Combine::apply(
+              carry_in[c][k], static_cast<acc_t>(output_data[i + k])));
+        }
+      }
+    }
+  });
+}
+
+// Inclusive scan of input into output, which are flat and contiguous. With
+// reverse each line is scanned from its last element to its first.
+void _scan_kernel(
+    Tensor& output,
+    const Tensor& input,
+    const Tensor& plan,
+    ScanOp op,
+    bool reverse) {
+  const int64_t* plan_data = plan.data_ptr<int64_t>();
+  int64_t num_panels = plan.size(0) - 1;
+  AT_DISPATCH_ALL_TYPES_AND2(
+      kHalf, kBFloat16, input.scalar_type(), "NestedTensor_scan", [&] {
+        scalar_t* output_data = output.data_ptr<scalar_t>();
+        const scalar_t* input_data = input.data_ptr<scalar_t>();
+        switch (op) {
+          case ScanOp::Sum:
+            _scan_panels<scalar_t, ScanOp::Sum>(
+                output_data, input_data, plan_data, num_panels, reverse);
+            break;
+          case ScanOp::Prod:
+            _scan_panels<scalar_t, ScanOp::Prod>(
+                output_data, input_data, plan_data, num_panels, reverse);
+            break;
+          case ScanOp::LogSumExp:
+            _scan_panels<scalar_t, ScanOp::LogSumExp>(
+                output_data, input_data, plan_data, num_panels, reverse);
+            break;
+        }
+      });
+}
+
+Tensor _scan(const Tensor& input, const Tensor& plan, ScanOp op, bool reverse) {
+  Tensor output = at::empty_like(input, MemoryFormat::Contiguous);
+  _scan_kernel(output, input.contiguous(), plan, op, reverse);
+  return output;
+}
+
+// Gradient of the scan within each line. For logcumsumexp the positive and
+// negative parts of the gradient are accumulated in log space separately to
+// avoid overflow.
+struct SegmentedScan : public torch::autograd::Function<SegmentedScan> {
+  static Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      Tensor input,
+      Tensor plan,
+      int64_t op) {
+    Tensor output = _scan(input, plan, ScanOp(op), false);
+    ctx->saved_data["op"] = op;
+    ctx->save_for_backward({input, plan, output});
+    return output;
+  }
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs) {
+    auto saved = ctx->get_saved_variables();
+    Tensor input = saved[0];
+    Tensor plan = saved[1];
+    Tensor output = saved[2];
+    Tensor grad = grad_outputs[0];
+    Tensor grad_input;
+    switch (ScanOp(ctx->saved_data["op"].toInt())) {
+      case ScanOp::Sum:
+        grad_input = _scan(grad, plan, ScanOp::Sum, true);
+        break;
+      case ScanOp::Prod:
+        // Only used for inputs without zeros, see NestedTensor_cumprod.
+        grad_input = _scan(grad * output, plan, ScanOp::Sum, true) / input;
+        break;
+      case ScanOp::LogSumExp: {
+        Tensor positive = _scan(
+            at::log(grad.clamp_min(0)) - output, plan, ScanOp::LogSumExp, true);
+        Tensor negative = _scan(
+            at::log((-grad).clamp_min(0)) - output,
+            plan,
+            ScanOp::LogSumExp,
+            true);
+        grad_input = at::exp(positive + input) - at::exp(negative + input);
+        break;
+      }
+    }
+    return {grad_input, Tensor(), Tensor()};
+  }
+};
+
+// Runs the scan over the flat layout of the constiuents. Returns a packed
+// NestedTensor unless autograd is involved.
+Tensor _segmented_scan(const Tensor& self, int64_t dim, ScanOp op) {
+  auto nested_size = get_nested_tensor_impl(self)->nested_size();
+  const SizeTable& table = *nested_size;
+  Tensor flat;
+  if (is_packed(self)) {
+    flat = *get_nested_tensor(self).get_buffer();
+  } else {
+    flat = at::cat(
+        flatten(map([](at::Tensor t) { return t.reshape({-1}); },
+                    get_nested_tensor_structure(self)))
+            .vec(),
+        0);
+  }
+  Tensor plan = _scan_plan(table, dim);
+  Tensor result = flat.requires_grad()
+      ? SegmentedScan::apply(flat, plan, int64_t(op))
+      : _scan(flat, plan, op, false);
+  int64_t offset = 0;
+  TensorNode structure = map(
+      [&result, &offset](at::Tensor leaf) {
+        at::Tensor view =
+            result.narrow(0, offset, leaf.numel()).view(leaf.sizes());
+        offset += leaf.numel();
+        return view;
+      },
+      get_nested_tensor_structure(self));
+  if (result.requires_grad()) {
+    return wrap_tensor_node(std::move(structure));
+  }
+  return wrap_nested_tensor(
+      NestedTensor(std::move(result), std::move(structure)));
+}
+
+// Tensor dimension to scan along, or nullopt if the constiuents need to be
+// scanned one by one.
+c10::optional<int64_t> _scan_dim(const Tensor& self, int64_t dim) {
+  auto impl = get_nested_tensor_impl(self);
+  int64_t nested_dim = impl->nested_dim();
+  dim = maybe_wrap_dim(dim, self.dim());
+  TORCH_CHECK(
+      dim >= nested_dim,
+      "Scans along nested dimensions are not supported, but got dim ",
+      dim,
+      " for a NestedTensor of nested_dim ",
+      nested_dim,
+      ".");
+  if (!self.device().is_cpu() || impl->nested_size()->num_leaves() == 0) {
+    NestedTensorOpScope::record_fallback();
+    return c10::nullopt;
+  }
+  return dim - nested_dim;
+}
+
+Tensor NestedTensor_cumsum(
+    const Tensor& self,
+    int64_t dim,
+    c10::optional<ScalarType> dtype) {
+  if (auto tensor_dim = _scan_dim(self, dim)) {
+    ScalarType result_dtype = dtype
+        ? *dtype
+        : (isIntegralType(self.scalar_type(), true) ? kLong
+                                                    : self.scalar_type());
+    return _segmented_scan(
+        NestedTensor_to_dtype(self, result_dtype), *tensor_dim, ScanOp::Sum);
+  }
+  int64_t nested_dim = get_nested_tensor_impl(self)->nested_dim();
+  dim = maybe_wrap_dim(dim, self.dim());
+  return wrap_tensor_node(
+      map([&](at::Tensor t) { return at::cumsum(t, dim - nested_dim, dtype); },
+          get_nested_tensor_structure(self)));
+}
+
+Tensor NestedTensor_cumprod(
+    const Tensor& self,
+    int64_t dim,
+    c10::optional<ScalarType> dtype) {
+  auto tensor_dim = _scan_dim(self, dim);
+  // NOTE: The gradient divides by the input, so inputs with zeros that
+  // require grad go through at::cumprod.
+  TensorNode structure = get_nested_tensor_structure(self);
+  if (tensor_dim && !arena_eligible(structure)) {
+    for (at::Tensor leaf : flatten(structure)) {
+      if (leaf.eq(0).any().item<bool>()) {
+        NestedTensorOpScope::record_fallback();
+        tensor_dim = c10::nullopt;
+        break;
+      }
+    }
+  }
+  if (tensor_dim) {
+    ScalarType result_dtype = dtype
+        ? *dtype
+        : (isIntegralType(self.scalar_type(), true) ? kLong
+                                                    : self.scalar_type());
+    return _segmented_scan(
+        NestedTensor_to_dtype(self, result_dtype), *tensor_dim, ScanOp::Prod);
+  }
+  int64_t nested_dim = get_nested_tensor_impl(self)->nested_dim();
+  dim = maybe_wrap_dim(dim, self.dim());
+  return wrap_tensor_node(
+      map([&](at::Tensor t) { return at::cumprod(t, dim - nested_dim, dtype); },
+          get_nested_tensor_structure(self)));
+}
+
+Tensor NestedTensor_logcumsumexp(const Tensor& self, int64_t dim) {
+  if (auto tensor_dim = _scan_dim(self, dim)) {
+    TORCH_CHECK(
+        isFloatingType(self.scalar_type()),
+        "logcumsumexp requires floating point constiuents.");
+    return _segmented_scan(self, *tensor_dim, ScanOp::LogSumExp);
+  }
+  int64_t nested_dim = get_nested_tensor_impl(self)->nested_dim();
+  dim = maybe_wrap_dim(dim, self.dim());
+  return wrap_tensor_node(
+      map([&](at::Tensor t) { return at::logcumsumexp(t, dim - nested_dim); },
+          get_nested_tensor_structure(self)));
+}
+
+TORCH_LIBRARY_IMPL(aten, PrivateUse1_PreAutograd, m) {
+  NESTED_TENSOR_IMPL("cumsum", NestedTensor_cumsum);
+  NESTED_TENSOR_IMPL("cumprod", NestedTensor_cumprod);
+  NESTED_TENSOR_IMPL("logcumsumexp", NestedTensor_logcumsumexp);
+}
+
+} // namespace at
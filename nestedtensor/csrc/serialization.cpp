@@ -0,0 +1,270 @@
+#include <nestedtensor/csrc/serialization.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'E', 'S', 'T', 'E', 'D', 'T', 'N'};
+constexpr int64_t kVersion = 1;
+
+struct Header {
+  char magic[8];
+  int64_t version;
+  int64_t scalar_type;
+  int64_t nested_dim;
+  int64_t tensor_dim;
+  int64_t num_nodes;
+  int64_t num_leaves;
+  int64_t data_offset;
+  int64_t data_numel;
+};
+
+void _collect(
+    const TensorNode& node,
+    std::vector<int64_t>& degrees,
+    std::vector<at::Tensor>& leaves) {
+  if (node.is_leaf()) {
+    leaves.push_back(node.payload());
+    return;
+  }
+  degrees.push_back(node.degree());
+  for (size_t i = 0; i < node.degree(); i++) {
+    _collect(node.children(i), degrees, leaves);
+  }
+}
+
+TensorNode _build(
+    const int64_t* degrees,
+    int64_t num_nodes,
+    int64_t& node_index,
+    std::vector<at::Tensor>& leaves,
+    int64_t& leaf_index,
+    int64_t height) {
+  if (height == 0) {
+    TORCH_CHECK(
+        leaf_index < int64_t(leaves.size()),
+        "Corrupted NestedTensor file: structure references more constiuents than stored.");
+    return TensorNode(std::move(leaves[leaf_index++]));
+  }
+  TORCH_CHECK(
+      node_index < num_nodes,
+      "Corrupted NestedTensor file: structure table is truncated.");
+  int64_t degree = degrees[node_index++];
+  std::vector<TensorNode> children;
+  for (int64_t i = 0; i < degree; i++) {
+    children.push_back(
+        _build(degrees, num_nodes, node_index, leaves, leaf_index, height - 1));
+  }
+  return TensorNode(std::move(children));
+}
+
+// The header and tables are untrusted, so sizes computed from them are
+// checked for overflow before they are compared against the file's length.
+// Both arguments need to be non-negative.
+int64_t _checked_add(int64_t a, int64_t b) {
+  TORCH_CHECK(
+      a <= std::numeric_limits<int64_t>::max() - b,
+      "Corrupted NestedTensor file: sizes overflow.");
+  return a + b;
+}
+
+int64_t _checked_mul(int64_t a, int64_t b) {
+  TORCH_CHECK(
+      b == 0 || a <= std::numeric_limits<int64_t>::max() / b,
+      "Corrupted NestedTensor file: sizes overflow.");
+  return a * b;
+}
+
+template <typename T>
+void _write(std::ofstream& out, const T* data, size_t count) {
+  out.write(reinterpret_cast<const char*>(data), sizeof(T) * count);
+}
+
+} // namespace
+
+void save_nested_tensor(const at::Tensor& tensor, const std::string& path) {
+  auto nt = at::get_nested_tensor(tensor);
+  std::vector<int64_t> degrees;
+  std::vector<at::Tensor> leaves;
+  _collect(nt.get_structure(), degrees, leaves);
+
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> offsets;
+  int64_t data_numel = 0;
+  for (const auto& leaf : leaves) {
+    for (int64_t size : leaf.sizes()) {
+      sizes.push_back(size);
+    }
+    offsets.push_back(data_numel);
+    data_numel += leaf.numel();
+  }
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.scalar_type =
+      static_cast<int64_t>(nt.get_first_variable().scalar_type());
+  header.nested_dim = nt.get_structure().height();
+  header.tensor_dim = nt.get_first_variable().dim();
+  header.num_nodes = degrees.size();
+  header.num_leaves = leaves.size();
+  int64_t table_bytes = sizeof(Header) +
+      sizeof(int64_t) * (degrees.size() + sizes.size() + offsets.size());
+  header.data_offset =
+      (table_bytes + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+  header.data_numel = data_numel;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  TORCH_CHECK(out.is_open(), "Could not open ", path, " for writing.");
+  _write(out, &header, 1);
+  _write(out, degrees.data(), degrees.size());
+  _write(out, sizes.data(), sizes.size());
+  _write(out, offsets.data(), offsets.size());
+  std::vector<char> padding(header.data_offset - table_bytes, 0);
+  _write(out, padding.data(), padding.size());
+  for (const auto& leaf : leaves) {
+    at::Tensor data = leaf.detach().cpu().contiguous();
+    _write(
+        out,
+        static_cast<const char*>(data.data_ptr()),
+        data.numel() * data.element_size());
+  }
+  TORCH_CHECK(out.good(), "Failed to write NestedTensor to ", path, ".");
+}
+
+at::Tensor load_nested_tensor(const std::string& path) {
+#ifdef _WIN32
+  TORCH_CHECK(false, "Loading NestedTensors is not supported on Windows.");
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  TORCH_CHECK(fd >= 0, "Could not open ", path, " for reading.");
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    TORCH_CHECK(false, "Could not stat ", path, ".");
+  }
+  size_t length = file_stat.st_size;
+  if (length < sizeof(Header)) {
+    close(fd);
+    TORCH_CHECK(false, path, " is not a NestedTensor file.");
+  }
+  // NOTE: The mapping is private, so that in-place operations on the
+  // constiuents are copy-on-write and never reach the file.
+  void* base =
+      mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  TORCH_CHECK(base != MAP_FAILED, "Could not map ", path, " into memory.");
+  // Owns the mapping. It is released once the last constiuent view dies or
+  // right away if the file turns out to be invalid.
+  std::shared_ptr<void> mapping(
+      base, [length](void* ptr) { munmap(ptr, length); });
+  const char* bytes = static_cast<const char*>(base);
+
+  Header header;
+  std::memcpy(&header, bytes, sizeof(Header));
+  TORCH_CHECK(
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0,
+      path,
+      " is not a NestedTensor file.");
+  TORCH_CHECK(
+      header.version == kVersion,
+      "Unsupported NestedTensor file version ",
+      header.version,
+      ".");
+  TORCH_CHECK(
+      header.scalar_type >= 0 &&
+          header.scalar_type <
+              static_cast<int64_t>(at::ScalarType::NumOptions),
+      "Corrupted NestedTensor file: invalid scalar type.");
+  TORCH_CHECK(
+      header.nested_dim > 0 && header.tensor_dim >= 0 &&
+          header.num_nodes >= 0 && header.num_leaves >= 0 &&
+          header.data_numel >= 0,
+      "Corrupted NestedTensor file: invalid header.");
+  at::ScalarType scalar_type = static_cast<at::ScalarType>(header.scalar_type);
+  int64_t table_entries = _checked_add(
+      header.num_nodes,
+      _checked_mul(header.num_leaves, _checked_add(header.tensor_dim, 1)));
+  int64_t table_bytes = _checked_add(
+      sizeof(Header), _checked_mul(sizeof(int64_t), table_entries));
+  int64_t data_bytes = _checked_mul(
+      header.data_numel, int64_t(c10::elementSize(scalar_type)));
+  TORCH_CHECK(
+      header.data_offset >= table_bytes &&
+          header.data_offset % kDataAlignment == 0 &&
+          _checked_add(header.data_offset, data_bytes) <= int64_t(length),
+      "Corrupted NestedTensor file: tables or data are truncated.");
+
+  const int64_t* degrees =
+      reinterpret_cast<const int64_t*>(bytes + sizeof(Header));
+  const int64_t* sizes = degrees + header.num_nodes;
+  const int64_t* offsets = sizes + header.num_leaves * header.tensor_dim;
+
+  at::Tensor buffer = at::from_blob(
+      const_cast<char*>(bytes) + header.data_offset,
+      {header.data_numel},
+      [mapping](void*) {},
+      at::TensorOptions().dtype(scalar_type));
+
+  std::vector<at::Tensor> leaves;
+  bool packed = true;
+  int64_t expected_offset = 0;
+  for (int64_t i = 0; i < header.num_leaves; i++) {
+    std::vector<int64_t> leaf_sizes(
+        sizes + i * header.tensor_dim, sizes + (i + 1) * header.tensor_dim);
+    int64_t numel = 1;
+    for (int64_t size : leaf_sizes) {
+      TORCH_CHECK(size >= 0, "Corrupted NestedTensor file: negative size.");
+      numel = _checked_mul(numel, size);
+    }
+    TORCH_CHECK(
+        offsets[i] >= 0 &&
+            _checked_add(offsets[i], numel) <= header.data_numel,
+        "Corrupted NestedTensor file: constiuent out of bounds.");
+    packed = packed && (offsets[i] == expected_offset);
+    expected_offset = offsets[i] + numel;
+    leaves.push_back(buffer.narrow(0, offsets[i], numel).view(leaf_sizes));
+  }
+
+  int64_t node_index = 0;
+  int64_t leaf_index = 0;
+  TensorNode structure = _build(
+      degrees,
+      header.num_nodes,
+      node_index,
+      leaves,
+      leaf_index,
+      header.nested_dim);
+  TORCH_CHECK(
+      node_index == header.num_nodes && leaf_index == header.num_leaves,
+      "Corrupted NestedTensor file: structure doesn't match constiuents.");
+  if (header.num_leaves == 0) {
+    // Without constiuents only the header knows the dtype and tensor_dim.
+    return at::wrap_nested_tensor(NestedTensor(
+        std::move(structure),
+        at::empty(
+            std::vector<int64_t>(header.tensor_dim, 0),
+            at::TensorOptions().dtype(scalar_type))));
+  }
+  if (packed && expected_offset == header.data_numel) {
+    return at::wrap_nested_tensor(
+        NestedTensor(std::move(buffer), std::move(structure)));
+  }
+  return at::wrap_tensor_node(std::move(structure));
+#endif
+}
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,29 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// On-disk layout of a NestedTensor. All integers are int64_t in host byte
+// order.
+//
+//   header      magic, version, scalar_type, nested_dim, tensor_dim,
+//               num_nodes, num_leaves, data_offset, data_numel
+//   structure   degree of each non-leaf node in pre-order (num_nodes)
+//   sizes       sizes of each constiuent (num_leaves x tensor_dim)
+//   offsets     element offset of each constiuent into data (num_leaves)
+//   data        all constiuents back-to-back in pre-order, contiguous and
+//               starting at data_offset, which is aligned to kDataAlignment
+//
+// load_nested_tensor maps the file into memory and returns a NestedTensor
+// whose constiuents are views into the mapping. Nothing is read or copied
+// upfront. The mapping is private, so in-place modifications never reach
+// the file, and it is released once the last view dies.
+
+constexpr int64_t kDataAlignment = 64;
+
+void save_nested_tensor(const at::Tensor& tensor, const std::string& path);
+at::Tensor load_nested_tensor(const std::string& path);
+
+} // namespace nested_tensor
+} // namespace torch
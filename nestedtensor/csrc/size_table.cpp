@@ -0,0 +1,109 @@
+#include <nestedtensor/csrc/size_table.h>
+
+namespace torch {
+namespace nested_tensor {
+
+SizeTable _size_table(const TensorNode& structure, bool strides) {
+  SizeTable table;
+  std::vector<const TensorNode*> nodes = {&structure};
+  for (int64_t level = 0; level < structure.height(); level++) {
+    std::vector<int64_t> offsets(1, 0);
+    std::vector<const TensorNode*> children;
+    for (const TensorNode* node : nodes) {
+      for (size_t i = 0; i < node->degree(); i++) {
+        children.push_back(&node->children(i));
+      }
+      offsets.push_back(children.size());
+    }
+    table._level_offsets.push_back(std::move(offsets));
+    nodes = std::move(children);
+  }
+  table._num_leaves = nodes.size();
+  if (nodes.size() == 0) {
+    return table;
+  }
+
+  auto entries = [strides](const TensorNode* node) {
+    return strides ? node->payload().strides() : node->payload().sizes();
+  };
+  at::IntArrayRef first = entries(nodes[0]);
+  for (int64_t entry : first) {
+    table._uniform.push_back(entry);
+  }
+  for (const TensorNode* node : nodes) {
+    at::IntArrayRef leaf = entries(node);
+    TORCH_CHECK(
+        leaf.size() == first.size(),
+        "All constiuents need to be of the same dimension.");
+    for (size_t dim = 0; dim < leaf.size(); dim++) {
+      if (table._uniform[dim] && *table._uniform[dim] != leaf[dim]) {
+        table._uniform[dim] = c10::nullopt;
+      }
+    }
+  }
+  for (const auto& entry : table._uniform) {
+    table._columns.push_back(entry ? -1 : table._num_columns++);
+  }
+  if (table._num_columns == 0) {
+    return table;
+  }
+  table._table.reserve(nodes.size() * table._num_columns);
+  for (const TensorNode* node : nodes) {
+    at::IntArrayRef leaf = entries(node);
+    for (size_t dim = 0; dim < leaf.size(); dim++) {
+      if (!table._uniform[dim]) {
+        table._table.push_back(leaf[dim]);
+      }
+    }
+  }
+  return table;
+}
+
+SizeTable nested_size_table(const TensorNode& structure) {
+  return _size_table(structure, false);
+}
+
+SizeTable nested_stride_table(const TensorNode& structure) {
+  return _size_table(structure, true);
+}
+
+at::Tensor SizeTable::to_tensor() const {
+  at::Tensor result = at::empty({num_leaves(), tensor_dim()}, at::kLong);
+  int64_t* data = result.data_ptr<int64_t>();
+  for (int64_t leaf = 0; leaf < num_leaves(); leaf++) {
+    for (int64_t dim = 0; dim < tensor_dim(); dim++) {
+      data[leaf * tensor_dim() + dim] = get(leaf, dim);
+    }
+  }
+  return result;
+}
+
+std::vector<c10::optional<int64_t>> construct_size(const SizeTable& table) {
+  std::vector<c10::optional<int64_t>> result;
+  for (int64_t level = 0; level < table.nested_dim(); level++) {
+    if (table.num_nodes(level) == 0) {
+      return result;
+    }
+    c10::optional<int64_t> degree = table.degree(level, 0);
+    for (int64_t node = 1; node < table.num_nodes(level); node++) {
+      if (table.degree(level, node) != *degree) {
+        degree = c10::nullopt;
+        break;
+      }
+    }
+    result.push_back(degree);
+  }
+  if (table.num_leaves() > 0) {
+    for (const auto& entry : table.uniform()) {
+      result.push_back(entry);
+    }
+  }
+  return result;
+}
+
+bool shape_matches(const SizeTable& a, const SizeTable& b) {
+  return a._level_offsets == b._level_offsets;
+}
+
+} // namespace nested_tensor
+} // namespace torch
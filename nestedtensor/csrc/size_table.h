@@ -0,0 +1,120 @@
+#pragma once
+#include <nestedtensor/csrc/utils/nested_node.h>
+#include <ATen/ATen.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// Compact nested size (or stride) of a NestedTensor. Unlike a SizeNode it
+// doesn't allocate a List per constiuent, but stores
+//
+//   - per nested level, the offsets of each node's children into the next
+//     level in the style of CSR, i.e. the children of node i at level l are
+//     the nodes [offsets[l][i], offsets[l][i + 1]) at level l + 1, and the
+//     nodes at level nested_dim are the constiuents,
+//   - the tensor dimensions shared by all constiuents once, and
+//   - an int64 matrix of size [num_leaves, number of differing dimensions]
+//     for the rest.
+struct SizeTable {
+  int64_t nested_dim() const {
+    return _level_offsets.size();
+  }
+  int64_t tensor_dim() const {
+    return _uniform.size();
+  }
+  int64_t num_leaves() const {
+    return _num_leaves;
+  }
+  // Number of nodes at the given nested level. Level 0 is the root.
+  int64_t num_nodes(int64_t level) const {
+    return _level_offsets[level].size() - 1;
+  }
+  int64_t child_begin(int64_t level, int64_t node) const {
+    return _level_offsets[level][node];
+  }
+  int64_t child_end(int64_t level, int64_t node) const {
+    return _level_offsets[level][node + 1];
+  }
+  int64_t degree(int64_t level, int64_t node) const {
+    return child_end(level, node) - child_begin(level, node);
+  }
+  // Entry of the given constiuent along tensor dimension dim.
+  int64_t get(int64_t leaf, int64_t dim) const {
+    if (_uniform[dim]) {
+      return *_uniform[dim];
+    }
+    return _table[leaf * _num_columns + _columns[dim]];
+  }
+  std::vector<int64_t> get(int64_t leaf) const {
+    std::vector<int64_t> result(tensor_dim());
+    for (int64_t dim = 0; dim < tensor_dim(); dim++) {
+      result[dim] = get(leaf, dim);
+    }
+    return result;
+  }
+  // Entries shared by all constiuents and nullopt where they differ.
+  const std::vector<c10::optional<int64_t>>& uniform() const {
+    return _uniform;
+  }
+  const std::vector<int64_t>& level_offsets(int64_t level) const {
+    return _level_offsets[level];
+  }
+  // All entries as an int64 Tensor of size [num_leaves, tensor_dim].
+  at::Tensor to_tensor() const;
+
+  friend SizeTable _size_table(const TensorNode&, bool);
+  friend bool shape_matches(const SizeTable&, const SizeTable&);
+
+ private:
+  SizeTable() : _num_leaves(0), _num_columns(0) {}
+
+  std::vector<std::vector<int64_t>> _level_offsets;
+  int64_t _num_leaves;
+  std::vector<c10::optional<int64_t>> _uniform;
+  // Column of each differing dimension in _table.
+  std::vector<int64_t> _columns;
+  int64_t _num_columns;
+  std::vector<int64_t> _table;
+};
+
+SizeTable nested_size_table(const TensorNode& structure);
+SizeTable nested_stride_table(const TensorNode& structure);
+
+// Computes the size of a NestedTensor from the sizes of its constiuents.
+// Dimensions along which the constiuents disagree are nullopt.
+std::vector<c10::optional<int64_t>> construct_size(const SizeTable& table);
+
+// Whether both describe the same nested structure. Like shape_matches for
+// NestedNodes this doesn't compare the entries of the constiuents.
+bool shape_matches(const SizeTable& a, const SizeTable& b);
+
+// Rebuilds the nested structure with fn(i) as the i-th constiuent.
+template <class F>
+NestedNode<typename c10::guts::infer_function_traits<F>::type::return_type>
+_table_map(const SizeTable& table, F& fn, int64_t level, int64_t node) {
+  if (level == table.nested_dim()) {
+    return NestedNode<
+        typename c10::guts::infer_function_traits<F>::type::return_type>(
+        fn(node));
+  }
+  std::vector<NestedNode<
+      typename c10::guts::infer_function_traits<F>::type::return_type>>
+      children;
+  for (int64_t i = table.child_begin(level, node);
+       i < table.child_end(level, node);
+       i++) {
+    children.push_back(_table_map(table, fn, level + 1, i));
+  }
+  return NestedNode<
+      typename c10::guts::infer_function_traits<F>::type::return_type>(
+      std::move(children));
+}
+
+template <class F>
+NestedNode<typename c10::guts::infer_function_traits<F>::type::return_type>
+table_map(const SizeTable& table, F fn) {
+  return _table_map(table, fn, 0, 0);
+}
+
+} // namespace nested_tensor
+} // namespace torch
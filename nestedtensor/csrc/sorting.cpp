@@ -0,0 +1,96 @@
+#include <ATen/WrapDimUtils.h>
+#include <nestedtensor/csrc/sorting.h>
+#include <nestedtensor/csrc/utils/nested_node_functions.h>
+#include <algorithm>
+#include <numeric>
+
+namespace torch {
+namespace nested_tensor {
+
+namespace {
+
+// Size along dim of each entry along nested dimension 0. For nested_dim > 1
+// an entry is a subtree and we use the largest size among its constiuents,
+// since that's what it pads to.
+std::vector<int64_t> _entry_sizes(const at::Tensor& tensor, int64_t dim) {
+  auto impl = at::get_nested_tensor_impl(tensor);
+  int64_t nested_dim = impl->nested_dim();
+  dim = at::maybe_wrap_dim(dim, tensor.dim());
+  TORCH_CHECK(
+      dim >= nested_dim,
+      "Can only sort by the size of a tensor dimension, but got dim ",
+      dim,
+      " for a NestedTensor of nested_dim ",
+      nested_dim,
+      ".");
+  int64_t tensor_dim = dim - nested_dim;
+  std::vector<int64_t> sizes;
+  for (const auto& child : impl->get_structure().unbind()) {
+    if (child.is_leaf()) {
+      sizes.push_back(child.payload().size(tensor_dim));
+      continue;
+    }
+    auto fn = [tensor_dim](at::Tensor leaf, int64_t input) {
+      return std::max(input, leaf.size(tensor_dim));
+    };
+    sizes.push_back(reduce<decltype(fn), int64_t, at::Tensor>(child, fn, 0));
+  }
+  return sizes;
+}
+
+at::Tensor _index_tensor(const std::vector<int64_t>& index) {
+  return at::tensor(index, at::kLong);
+}
+
+} // namespace
+
+std::tuple<at::Tensor, at::Tensor> sort_by_size(
+    const at::Tensor& tensor,
+    int64_t dim,
+    bool descending) {
+  std::vector<int64_t> sizes = _entry_sizes(tensor, dim);
+  std::vector<int64_t> perm(sizes.size());
+  std::iota(perm.begin(), perm.end(), 0);
+  std::stable_sort(
+      perm.begin(), perm.end(), [&sizes, descending](int64_t a, int64_t b) {
+        return descending ? sizes[a] > sizes[b] : sizes[a] < sizes[b];
+      });
+  std::vector<int64_t> inverse(perm.size());
+  for (size_t i = 0; i < perm.size(); i++) {
+    inverse[perm[i]] = i;
+  }
+  return std::make_tuple(
+      at::index_select(tensor, 0, _index_tensor(perm)),
+      _index_tensor(inverse));
+}
+
+std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> bucketize_by_size(
+    const at::Tensor& tensor,
+    int64_t dim,
+    std::vector<int64_t> boundaries) {
+  TORCH_CHECK(
+      std::is_sorted(boundaries.begin(), boundaries.end()),
+      "boundaries must be sorted in ascending order.");
+  std::vector<int64_t> sizes = _entry_sizes(tensor, dim);
+  std::vector<std::vector<int64_t>> buckets(boundaries.size() + 1);
+  for (size_t i = 0; i < sizes.size(); i++) {
+    size_t bucket =
+        std::lower_bound(boundaries.begin(), boundaries.end(), sizes[i]) -
+        boundaries.begin();
+    buckets[bucket].push_back(i);
+  }
+  std::vector<at::Tensor> results;
+  std::vector<at::Tensor> indices;
+  for (const auto& bucket : buckets) {
+    if (bucket.size() == 0) {
+      continue;
+    }
+    at::Tensor index = _index_tensor(bucket);
+    results.push_back(at::index_select(tensor, 0, index));
+    indices.push_back(index);
+  }
+  return std::make_tuple(results, indices);
+}
+
+} // namespace nested_tensor
+} // namespace torch
@@ -0,0 +1,30 @@
+#pragma once
+#include <nestedtensor/csrc/nested_tensor_impl.h>
+
+namespace torch {
+namespace nested_tensor {
+
+// Utilities to reorder and group constiuents by their size, so that
+// padding them (e.g. via to_tensor_mask) wastes as little as possible.
+// They operate on the entries along nested dimension 0 and dim refers to a
+// dimension of the NestedTensor, which must be a tensor dimension.
+
+// Stable sort of the entries by their size along dim. Returns the sorted
+// NestedTensor and the inverse permutation, i.e. an index such that
+// sorted.index_select(0, inverse) equals tensor.
+std::tuple<at::Tensor, at::Tensor> sort_by_size(
+    const at::Tensor& tensor,
+    int64_t dim,
+    bool descending);
+
+// Splits the entries into buckets by their size along dim. An entry of size
+// s ends up in bucket i if boundaries[i - 1] < s <= boundaries[i], which
+// matches torch.bucketize. Empty buckets are dropped. Returns the buckets
+// along with the indices of their entries in tensor.
+std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> bucketize_by_size(
+    const at::Tensor& tensor,
+    int64_t dim,
+    std::vector<int64_t> boundaries);
+
+} // namespace nested_tensor
+} // namespace torch
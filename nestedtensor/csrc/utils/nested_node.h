@@ -1,8 +1,10 @@
 #pragma once
 #include <ATen/core/List.h>
+#include <c10/util/Exception.h>
 #include <c10/util/Metaprogramming.h>
 #include <c10/util/Optional.h>
 #include <c10/util/TypeList.h>
+#include <memory>
 
 namespace torch {
 namespace nested_tensor {
@@ -17,8 +19,13 @@ struct NestedNode {
   // NestedNode() : _is_leaf(false), _height(1) {}
   NestedNode() = delete;
   NestedNode(std::vector<NestedNode<T>>&& children)
-      : _is_leaf(false), _children(children), _height(1) {
-    for (const auto& child : children) {
+      : _is_leaf(false),
+        _children(std::make_shared<const std::vector<NestedNode<T>>>(
+            std::move(children))),
+        _offset(0),
+        _degree(_children->size()),
+        _height(1) {
+    for (const auto& child : *_children) {
       if (child.height() + 1 > _height) {
         _height = child.height() + 1;
       }
@@ -27,18 +34,41 @@ struct NestedNode {
   // NestedNode(NestedNode&) = delete;
   // NestedNode(const NestedNode&) = delete;
   // NestedNode& operator=(NestedNode) = delete;
-  NestedNode(T&& payload) : _is_leaf(true), _payload(payload), _height(0) {}
+  NestedNode(T&& payload)
+      : _is_leaf(true), _offset(0), _degree(0), _payload(payload), _height(0) {}
   inline bool is_leaf() const {
     return _is_leaf;
   }
   inline size_t degree() const {
-    return _children.size();
+    return _degree;
   }
   inline int64_t height() const {
     return _height;
   }
   inline const std::vector<NestedNode<T>> unbind() const {
-    return _children;
+    if (_is_leaf) {
+      return {};
+    }
+    return std::vector<NestedNode<T>>(
+        _children->begin() + _offset, _children->begin() + _offset + _degree);
+  }
+  // Returns the children start to start + length as a new node. The
+  // children are shared, not copied, so this is constant time.
+  inline NestedNode<T> narrow(size_t start, size_t length) const {
+    TORCH_CHECK(!_is_leaf, "Cannot narrow a leaf.");
+    TORCH_CHECK(
+        start + length <= _degree,
+        "Narrowing to ",
+        start,
+        " + ",
+        length,
+        " exceeds degree ",
+        _degree,
+        ".");
+    NestedNode<T> result(*this);
+    result._offset = _offset + start;
+    result._degree = length;
+    return result;
   }
 
   template <typename A>
@@ -78,8 +108,8 @@ struct NestedNode {
   friend inline void
   apply(F&&, NestedNode<A>...);
 
-  inline NestedNode<T> children(size_t i) const {
-    return _children[i];
+  inline const NestedNode<T>& children(size_t i) const {
+    return (*_children)[_offset + i];
   }
 
   inline const T& payload() const {
@@ -92,7 +122,11 @@ struct NestedNode {
 
  private:
   bool _is_leaf;
-  std::vector<NestedNode<T>> _children;
+  // NOTE: Nodes are immutable, so copies and narrowed nodes share their
+  // children. This node's children are _degree entries from _offset on.
+  std::shared_ptr<const std::vector<NestedNode<T>>> _children;
+  size_t _offset;
+  size_t _degree;
   // TODO: Make this const?
   // _VariableNode _variable_node;
   T _payload;
@@ -294,7 +328,7 @@ class _apply<F, c10::guts::typelist::typelist<Args...>> {
       std::forward<F>(fn)(nested_node._payload...);
     } else {
       for (size_t i = 0; i < first_node.degree(); i++) {
-        function(std::forward<F>(fn), nested_node._children[i]...);
+        function(std::forward<F>(fn), nested_node.children(i)...);
       }
     }
   };
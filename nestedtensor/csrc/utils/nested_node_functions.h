@@ -1,5 +1,8 @@
 #pragma once
+#include <ATen/ATen.h>
 #include <nestedtensor/csrc/utils/nested_node.h>
+#include <map>
+#include <memory>
 
 namespace torch {
 namespace nested_tensor {
@@ -103,5 +106,68 @@ inline bool any(F&& fn, const NestedNode<B>&... nested_node) {
   return false;
 }
 
+// Groups of constiuent indices, in tree order, that share the same size.
+// NestedTensorImpl caches the plan of each version, see bucket_plan().
+struct BucketPlan {
+  std::vector<std::vector<int64_t>> buckets;
+};
+
+inline std::shared_ptr<const BucketPlan> build_bucket_plan(
+    const std::vector<at::Tensor>& leaves) {
+  auto plan = std::make_shared<BucketPlan>();
+  std::map<std::vector<int64_t>, size_t> bucket_index;
+  for (size_t i = 0; i < leaves.size(); i++) {
+    auto sizes = leaves[i].sizes().vec();
+    auto it = bucket_index.find(sizes);
+    if (it == bucket_index.end()) {
+      bucket_index[sizes] = plan->buckets.size();
+      plan->buckets.push_back({int64_t(i)});
+    } else {
+      plan->buckets[it->second].push_back(i);
+    }
+  }
+  return plan;
+}
+
+// Like map, but for ops that take a batch of inputs along a new leading
+// dimension, such as conv2d. Constiuents of equal size are stacked and fn
+// runs once per such bucket. The results are scattered back into tree
+// order. fn must not mix entries of a batch.
+//
+// NOTE: All constiuents must share dtype and device, which holds for the
+// constiuents of a NestedTensor. plan has to be built from the
+// constiuents of structure.
+template <class F>
+inline NestedNode<at::Tensor> batched_map(
+    F&& fn,
+    const NestedNode<at::Tensor>& structure,
+    const BucketPlan& plan) {
+  std::vector<at::Tensor> leaves = flatten(structure).vec();
+  std::vector<at::Tensor> results(leaves.size());
+  for (const auto& bucket : plan.buckets) {
+    if (bucket.size() == 1) {
+      results[bucket[0]] = fn(leaves[bucket[0]].unsqueeze(0)).select(0, 0);
+      continue;
+    }
+    std::vector<at::Tensor> inputs;
+    for (int64_t i : bucket) {
+      inputs.push_back(leaves[i]);
+    }
+    std::vector<at::Tensor> outputs = fn(at::stack(inputs)).unbind(0);
+    for (size_t j = 0; j < bucket.size(); j++) {
+      results[bucket[j]] = outputs[j];
+    }
+  }
+  return unflatten(structure, c10::List<at::Tensor>(results));
+}
+
+template <class F>
+inline NestedNode<at::Tensor> batched_map(
+    F&& fn,
+    const NestedNode<at::Tensor>& structure) {
+  auto plan = build_bucket_plan(flatten(structure).vec());
+  return batched_map(std::forward<F>(fn), structure, *plan);
+}
+
 } // namespace nested_tensor
 } // namespace torch
@@ -0,0 +1,115 @@
+from . import nested
+from nestedtensor import _C
+
+
+class BatchedRequest(object):
+    """
+    Result of a request submitted to a DynamicBatcher.
+    """
+
+    def __init__(self, impl):
+        self._impl = impl
+
+    def done(self):
+        return self._impl.done()
+
+    def wait(self, timeout_ms=None):
+        """
+        Blocks until the batch of this request was completed and returns its
+        entry of the batch's result. Raises the error the batch failed with.
+        Returns None if ```timeout_ms``` passed first.
+        """
+        return nested._wrap_result(self._impl.wait(timeout_ms))
+
+
+class DynamicBatch(object):
+    """
+    A batch of requests handed out by DynamicBatcher.next_batch. Either
+    complete or fail it once it has been processed.
+    """
+
+    def __init__(self, impl):
+        self._impl = impl
+
+    @property
+    def input(self):
+        """
+        Packed NestedTensor with one entry per request in arrival order.
+        """
+        return nested.NestedTensor(self._impl.input())
+
+    def complete(self, result):
+        """
+        Scatters the entries of ```result``` along dimension 0, which can be
+        a NestedTensor or a Tensor, back to the requests.
+        """
+        if isinstance(result, nested.NestedTensor):
+            result = result._impl
+        self._impl.complete(result)
+
+    def fail(self, message):
+        self._impl.fail(message)
+
+    def __len__(self):
+        return len(self._impl)
+
+
+class DynamicBatcher(object):
+    """
+    Groups variable-length Tensors submitted from any number of threads into
+    packed NestedTensors for a single consumer thread.
+
+    A batch is handed out once it holds ```max_tokens``` tokens (entries
+    along dimension 0 of the requests) or ```max_batch_size``` requests, or
+    once its oldest request has waited for ```max_latency_ms```. Requests are
+    copied into the packed buffer of the batch as they are picked up and
+    results are scattered back through the BatchedRequest returned by submit.
+    """
+
+    def __init__(self, max_tokens, max_latency_ms, max_batch_size=None):
+        self._impl = _C.DynamicBatcher(max_tokens, max_latency_ms, max_batch_size)
+
+    def submit(self, tensor):
+        """
+        Enqueues ```tensor``` without blocking. Safe to call from any thread.
+        """
+        return BatchedRequest(self._impl.submit(tensor))
+
+    def next_batch(self, timeout_ms=None):
+        """
+        Blocks until the next batch is due and returns it. Returns None if
+        ```timeout_ms``` passed first, or, without a timeout, once the
+        batcher was closed and all requests were handed out.
+        """
+        batch = self._impl.next_batch(timeout_ms)
+        if batch is None:
+            return None
+        return DynamicBatch(batch)
+
+    def serve(self, fn):
+        """
+        Runs ```fn``` on every batch until the batcher is closed. Errors
+        raised by ```fn``` or while scattering its result, e.g. because it
+        doesn't have one entry per request, fail the requests of the batch
+        and serving continues with the next one.
+        """
+        while True:
+            batch = self.next_batch()
+            if batch is None:
+                return
+            try:
+                batch.complete(fn(batch.input))
+            except Exception as e:
+                batch.fail(str(e))
+
+    def close(self):
+        """
+        Rejects further requests and hands out the pending ones right away.
+        """
+        self._impl.close()
+
+    def closed(self):
+        return self._impl.closed()
+
+    def pending(self):
+        return self._impl.pending()
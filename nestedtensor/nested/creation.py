@@ -31,3 +31,36 @@ def as_nested_tensor(data, dtype=None, device=None, requires_grad=False, pin_mem
         if pin_memory:
             data = data.pin_memory()
     return data
+
+
+class NestedTensorBuilder(object):
+    """
+    Builds a NestedTensor from Tensors that arrive one at a time.
+
+    Each appended Tensor is detached, copied into a packed buffer right
+    away and checked against the first one for dimension, layout, device
+    and dtype. finish returns a NestedTensor of views into that buffer
+    without copying the data again and resets the builder. Only if the
+    buffer grew much larger than needed, the data is copied into one that
+    fits once more, so the result doesn't keep the unused memory alive.
+    The result does not require grad; call requires_grad_ on it if needed.
+    """
+
+    def __init__(self):
+        self._impl = _C.NestedTensorBuilder()
+
+    def reserve(self, numel):
+        """
+        Makes room for a total of ```numel``` elements across all constiuents.
+        Requires at least one constiuent to have been appended.
+        """
+        self._impl.reserve(numel)
+
+    def append(self, tensor):
+        self._impl.append(tensor)
+
+    def finish(self):
+        return nested.NestedTensor(self._impl.finish())
+
+    def __len__(self):
+        return len(self._impl)
@@ -0,0 +1,37 @@
+import torch
+from . import nested
+
+
+def _check(data):
+    if not isinstance(data, nested.NestedTensor):
+        raise TypeError("Expected a NestedTensor, but got " + str(type(data)))
+
+
+def dropout(data, p=0.5, seed=None):
+    """
+    Dropout over all constiuents of ```data``` in a single pass. Whether an
+    element is kept only depends on ```seed``` and the element's position in
+    the packed layout of ```data```, so the same seed always yields the same
+    mask. If no ```seed``` is given a new one is drawn from the default
+    generator.
+
+    Returns the result along with the seed, which is all that is needed to
+    recompute the mask via dropout_mask. Constiuents that require grad are
+    supported and the backward pass recomputes the mask from the seed, too.
+    """
+    _check(data)
+    if seed is None:
+        result, seed = torch.ops.nestedtensor.dropout(data._impl, p)
+    else:
+        result = torch.ops.nestedtensor.dropout_with_seed(data._impl, p, seed)
+    return nested.NestedTensor(result), seed
+
+
+def dropout_mask(data, p, seed):
+    """
+    Returns the mask ```dropout(data, p, seed)``` applies as a NestedTensor
+    of bool constiuents.
+    """
+    _check(data)
+    return nested.NestedTensor(
+        torch.ops.nestedtensor.dropout_mask(data._impl, p, seed))
@@ -10,30 +10,28 @@ from . import creation
 import nestedtensor
 import itertools
 
-def _wrap_result(result):
-    return (
-        NestedTensor(result)
-        if torch.is_tensor(result) and torch.ops.nestedtensor.is_nested_tensor_impl(result)
-        else result
-    )
+from nestedtensor import _C
+
+# NOTE: Unwrapping arguments and wrapping results is done by _C, since
+# these run on every single op and dominate the cost of small ops.
+_wrap_result = _C._wrap_result
+
 
 def _filter_impl(args, kwargs):
-    if kwargs is None:
-        kwargs = {}
-    impl_args = [a._impl if isinstance(a, NestedTensor) else a for a in args]
-    impl_kwargs = {
-        k: v._impl if isinstance(v, NestedTensor) else v for (k, v) in kwargs.items()
-    }
-    return impl_args, impl_kwargs
+    return _C._filter_impl(tuple(args), kwargs)
+
+
+def _method(name):
+    def _wrapped_fn(*args, **kwargs):
+        return _C._call_method(name, args, kwargs)
+    _wrapped_fn.__name__ = name
+    return _wrapped_fn
+
 
 class NestedTensorMeta(type):
     def __getattr__(cls, name):
         if getattr(torch.Tensor, name):
-            def _wrapped_fn(*args, **kwargs):
-                impl_args, impl_kwargs = _filter_impl(args, kwargs)
-                result = getattr(impl_args[0], name)(*(impl_args[1:]), **impl_kwargs)
-                return _wrap_result(result)
-            return _wrapped_fn
+            return _method(name)
         return self.__dict__[name]
 
 # -------------------------NestedTensor core---------------------------
@@ -61,10 +59,14 @@ class NestedTensor(metaclass = NestedTensorMeta):
 
     def __getattr__(self, name):
         if getattr(self._impl, name):
+            # Methods of torch.Tensor are installed on the class the first
+            # time they're used, so that later lookups don't end up here.
+            if callable(getattr(torch.Tensor, name, None)):
+                method = _method(name)
+                setattr(NestedTensor, name, method)
+                return method.__get__(self)
             def _wrapped_fn(*args, **kwargs):
-                impl_args, impl_kwargs = _filter_impl(args, kwargs)
-                result = getattr(self._impl, name)(*impl_args, **impl_kwargs)
-                return _wrap_result(result)
+                return _C._call_method(name, (self,) + args, kwargs)
             return _wrapped_fn
         return self.__dict__[name]
 
@@ -168,6 +170,9 @@ class NestedTensor(metaclass = NestedTensorMeta):
         return tuple(torch.ops.nestedtensor.sizes(self._impl))
 
     def to(self, *args, **kwargs):
+        # NOTE: Pure dtype conversions are done in a single pass over the buffer.
+        if len(args) == 1 and not kwargs and isinstance(args[0], torch.dtype):
+            return _wrap_result(torch.ops.nestedtensor.to_dtype(self._impl, args[0]))
         # TODO: to is currently not supported by impls due to argparsing.
         new_tensors = [t.to(*args, **kwargs) for t in self.unbind()]
         # TODO: Make contiguous by default? Heavy operation...
@@ -209,25 +214,40 @@ class NestedTensor(metaclass = NestedTensorMeta):
         # the purpose of repr for torch.Tensor. Therefore returning str is ok.
         return self.__str__()
 
-    def nested_size(self, dim=None):
+    def nested_size(self, dim=None, as_tensor=False):
+        """
+        With ```as_tensor``` returns the sizes of all constiuents as a single
+        int64 Tensor of size [number of constiuents, tensor dimension]. For
+        nested_dim > 1 a list of offsets per nested level below the first is
+        returned alongside, such that the children of the i-th entry of a
+        level are the entries offsets[i] to offsets[i + 1] of the next level.
+        """
+        if as_tensor:
+            if dim is not None:
+                raise ValueError("nested_size doesn't support dim with as_tensor.")
+            return nestedtensor._C.nested_size_tensor(self._impl)
         return nestedtensor._C.nested_size(self._impl, dim)
 
-    def nested_stride(self, dim=None):
+    def nested_stride(self, dim=None, as_tensor=False):
+        """
+        See nested_size.
+        """
+        if as_tensor:
+            if dim is not None:
+                raise ValueError("nested_stride doesn't support dim with as_tensor.")
+            return nestedtensor._C.nested_stride_tensor(self._impl)
         return nestedtensor._C.nested_stride(self._impl, dim)
 
     # --- dependent on impl ends ---
 
     def __torch_function__(self, func, types, args=(), kwargs=None):
-        impl_args, impl_kwargs = _filter_impl(args, kwargs)
         # Need a specialized implementation to support lists of lists of sizes.
         if func is torch.nn.functional.interpolate:
-            return _wrap_result(nestedtensor._C.interpolate(*impl_args, **impl_kwargs))
+            func = nestedtensor._C.interpolate
         # Need a specialized implementation to dodge call to view in nll_loss
-        if func is torch.nn.functional.cross_entropy:
-            return _wrap_result(
-                nestedtensor._C.cross_entropy(*impl_args, **impl_kwargs)
-            )
-        return _wrap_result(func(*impl_args, **impl_kwargs))
+        elif func is torch.nn.functional.cross_entropy:
+            func = nestedtensor._C.cross_entropy
+        return _C._call_function(func, tuple(args), kwargs)
 
     # Might require nonzero
     def __bool__(self):
@@ -239,6 +259,16 @@ class NestedTensor(metaclass = NestedTensorMeta):
     def __iter__(self):
         return iter(self.unbind())
 
+    def jit_apply(self, fn, batch=False):
+        """
+        Applies the scripted function fn to each constiuent in parallel.
+
+        If batch is True, constiuents of the same size are stacked and fn is
+        applied once per stack. Only use this if fn treats the leading
+        dimension as a batch dimension.
+        """
+        return _wrap_result(_C.jit_apply(fn, self._impl, batch))
+
     def to_nested_tensor(self, dim=0):
         return _wrap_result(torch.ops.nestedtensor.to_nested_tensor(self._impl, dim))
 
@@ -263,5 +293,8 @@ class NestedTensor(metaclass = NestedTensorMeta):
         return masking.to_tensor_mask(self, mask_dim)
 
     def to_padded_tensor(self, mask_dim=None, padding=-1):
-        tensor, mask = masking.to_tensor_mask(self.to_list(), mask_dim)
-        return tensor.masked_fill(~mask, padding)
+        # NOTE: The padded tensor doesn't depend on mask_dim.
+        return torch.ops.nestedtensor.to_padded_tensor(self._impl, padding)
+
+
+_C._register_nested_tensor_class(NestedTensor)
@@ -0,0 +1,28 @@
+import torch
+from . import nested
+from nestedtensor import _C
+from torch.nn.utils.rnn import PackedSequence
+
+
+def to_packed_sequence(data):
+    """
+    Converts a NestedTensor of sequences, i.e. of nested_dim 1 with
+    constiuents of size ```(length, *)```, into a PackedSequence without
+    padding them first. Like ```pack_sequence(data.unbind(),
+    enforce_sorted=False)```, but gathers the data in a single pass.
+    """
+    if not isinstance(data, nested.NestedTensor):
+        raise TypeError("Expected a NestedTensor, but got " + str(type(data)))
+    return PackedSequence(*_C.to_packed_sequence(data._impl))
+
+
+def from_packed_sequence(sequence):
+    """
+    Converts a PackedSequence back into a NestedTensor with one constiuent
+    per sequence, in the order given by its ```unsorted_indices```.
+    """
+    return nested.NestedTensor(_C.from_packed_sequence(
+        sequence.data,
+        sequence.batch_sizes,
+        sequence.sorted_indices,
+        sequence.unsorted_indices))
@@ -0,0 +1,55 @@
+import torch
+from . import nested
+
+
+class QuantizedNestedTensor(object):
+    """
+    A NestedTensor stored as int8 constiuents packed into a single buffer,
+    along with an affine ```scale``` and ```zero_point``` per constiuent or, if
+    ```per_row```, per row (slice along the last dimension) of each constiuent.
+
+    A value q of the group g represents ```scale[g] * (q - zero_point[g])```.
+    """
+
+    def __init__(self, data, scale, zero_point, per_row=False):
+        self.data = data
+        self.scale = scale
+        self.zero_point = zero_point
+        self.per_row = per_row
+
+    def __len__(self):
+        return len(self.data)
+
+    def nested_dim(self):
+        return self.data.nested_dim()
+
+    def nested_size(self, dim=None):
+        return self.data.nested_size(dim)
+
+    def dequantize(self, dtype=torch.float32):
+        return nested.NestedTensor(torch.ops.nestedtensor.dequantize(
+            self.data._impl, self.scale, self.zero_point, self.per_row, dtype))
+
+    def matmul(self, weight):
+        """
+        Multiplies each constiuent with the dense 2-dimensional ```weight```
+        and returns a float NestedTensor. Blocks of rows of the int8 data are
+        widened to float and multiplied with a single matrix multiplication
+        each, so no float copy of all of the data is created.
+        """
+        return nested.NestedTensor(torch.ops.nestedtensor.quantized_matmul(
+            self.data._impl, self.scale, self.zero_point, self.per_row, weight))
+
+
+def quantize(data, per_row=False):
+    """
+    Quantizes the floating point NestedTensor ```data``` to int8 in a single
+    pass, choosing a scale and zero point per constiuent or, if ```per_row```,
+    per row of each constiuent.
+    """
+    if not isinstance(data, nested.NestedTensor):
+        raise TypeError("Expected a NestedTensor, but got " + str(type(data)))
+    result, scale, zero_point = torch.ops.nestedtensor.quantize(
+        data._impl, per_row)
+    return QuantizedNestedTensor(
+        nested.NestedTensor(result), scale, zero_point, per_row)
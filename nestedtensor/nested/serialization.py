@@ -0,0 +1,23 @@
+from . import nested
+from nestedtensor import _C
+
+
+def save(data, path):
+    """
+    Writes ```data``` to ```path``` in a compact binary format.
+
+    The constiuents are stored back-to-back in a single aligned blob
+    following a small header and a table of their sizes and offsets.
+    """
+    if not isinstance(data, nested.NestedTensor):
+        raise TypeError("Expected a NestedTensor, but got " + str(type(data)))
+    _C.save_nested_tensor(data._impl, path)
+
+
+def load(path):
+    """
+    Maps a file written by ```save``` into memory and returns a NestedTensor
+    whose constiuents are views into that mapping. No data is read or copied
+    upfront. In-place modifications of the result never reach the file.
+    """
+    return nested.NestedTensor(_C.load_nested_tensor(path))
@@ -0,0 +1,42 @@
+from . import nested
+from nestedtensor import _C
+
+
+def _check(data):
+    if not isinstance(data, nested.NestedTensor):
+        raise TypeError("Expected a NestedTensor, but got " + str(type(data)))
+
+
+def sort_by_size(data, dim=None, descending=False):
+    """
+    Stable sort of the entries of ```data``` by their size along ```dim```,
+    which must be a tensor dimension. Defaults to the first tensor dimension,
+    i.e. the length of sequences of size ```(length, *)```. Entries of nested
+    NestedTensors are sorted by the largest size among their constiuents.
+
+    Returns the sorted NestedTensor and the inverse permutation, i.e.
+    ```sorted.index_select(0, inverse)``` is ```data``` again.
+    """
+    _check(data)
+    if dim is None:
+        dim = data.nested_dim()
+    result, inverse = _C.sort_by_size(data._impl, dim, descending)
+    return nested.NestedTensor(result), inverse
+
+
+def bucketize_by_size(data, boundaries, dim=None):
+    """
+    Splits the entries of ```data``` into buckets by their size along ```dim```,
+    which defaults to the first tensor dimension like for sort_by_size,
+    such that each bucket only pads to its own largest entry. An entry of
+    size s goes into bucket i if ```boundaries[i - 1] < s <= boundaries[i]```,
+    just like torch.bucketize.
+
+    Returns a list of ```(bucket, index)``` pairs, one per non-empty bucket,
+    where ```index``` holds the positions of the bucket's entries in ```data```.
+    """
+    _check(data)
+    if dim is None:
+        dim = data.nested_dim()
+    buckets, indices = _C.bucketize_by_size(data._impl, dim, list(boundaries))
+    return [(nested.NestedTensor(b), i) for (b, i) in zip(buckets, indices)]
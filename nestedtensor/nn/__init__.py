@@ -1 +1,4 @@
 from .mha import MultiheadAttention
+from .rnn import lstm
+from .rnn import gru
+from .conv import conv1d
@@ -0,0 +1,20 @@
+import torch
+import nestedtensor
+
+
+def _single(x):
+    return list(x) if isinstance(x, (list, tuple)) else [x]
+
+
+def conv1d(input, weight, bias=None, stride=1, padding=0, dilation=1,
+           groups=1, padding_mode='zeros'):
+    """
+    conv1d over a NestedTensor of constiuents of size ```(channels, length)```
+    in a single call. Each constiuent is padded on its own according to
+    ```padding_mode```, which is one of 'zeros', 'reflect', 'replicate' and
+    'circular', so that no output mixes two constiuents. With the default
+    'zeros' this is what torch.nn.functional.conv1d does for NestedTensors.
+    """
+    return nestedtensor.NestedTensor(torch.ops.nestedtensor.conv1d(
+        input._impl, weight, bias, _single(stride), _single(padding),
+        _single(dilation), groups, padding_mode))
@@ -0,0 +1,45 @@
+import torch
+from torch import _VF
+import nestedtensor
+
+
+# NOTE: The sequences are packed into the PackedSequence layout natively, so
+# there is no padding in between. Hidden states are in the order of the
+# constiuents of input.
+
+
+def _zeros(module, input):
+    num_directions = 2 if module.bidirectional else 1
+    return torch.zeros(module.num_layers * num_directions,
+                       len(input),
+                       module.hidden_size,
+                       dtype=input.dtype,
+                       device=input.device)
+
+
+def lstm(module, input, hx=None):
+    """
+    Runs the torch.nn.LSTM ```module``` over each sequence of the NestedTensor
+    ```input```, whose constiuents are of size ```(length, input_size)```.
+    Returns the output NestedTensor and ```(h_n, c_n)```.
+    """
+    if hx is None:
+        hx = (_zeros(module, input), _zeros(module, input))
+    output, h, c = _VF.lstm(input._impl, hx, module._flat_weights, module.bias,
+                            module.num_layers, module.dropout, module.training,
+                            module.bidirectional, module.batch_first)
+    return nestedtensor.NestedTensor(output), (h, c)
+
+
+def gru(module, input, hx=None):
+    """
+    Runs the torch.nn.GRU ```module``` over each sequence of the NestedTensor
+    ```input```, whose constiuents are of size ```(length, input_size)```.
+    Returns the output NestedTensor and ```h_n```.
+    """
+    if hx is None:
+        hx = _zeros(module, input)
+    output, h = _VF.gru(input._impl, hx, module._flat_weights, module.bias,
+                        module.num_layers, module.dropout, module.training,
+                        module.bidirectional, module.batch_first)
+    return nestedtensor.NestedTensor(output), h
@@ -39,6 +39,18 @@ class TestNestedTensorAutograd(TestCase):
         self.assertIsNone(tensor2.grad)
         self.assertIsNotNone(nt2[0].grad)
 
+    def test_index_select_grad(self):
+        nt = nestedtensor.nested_tensor([torch.tensor([1., 2.]),
+                                         torch.tensor([3.]),
+                                         torch.tensor([4., 5., 6.])],
+                                        requires_grad=True)
+        result = nt.index_select(0, torch.tensor([2, 0, 2]))
+        sum(t.sum() for t in result.unbind()).backward()
+        # Gradients of repeated indices accumulate.
+        self.assertEqual(nt[0].grad, torch.tensor([1., 1.]))
+        self.assertIsNone(nt[1].grad)
+        self.assertEqual(nt[2].grad, torch.tensor([2., 2., 2.]))
+
     def test_grad_to_tensor_mask(self):
         def some_func(x):
             return torch.sum(x ** 2 + x ** 3)
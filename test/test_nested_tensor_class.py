@@ -7,6 +7,8 @@ import nestedtensor
 import unittest
 from utils import TestCase
 import random
+import os
+import tempfile
 
 import utils
 
@@ -77,6 +79,13 @@ class TestNestedTensor(TestCase):
         for i in range(num_tensors):
             self.assertNotEqual(tensors[i], nested_tensor.unbind()[i])
 
+        # Constiuents are copied into contiguous memory whatever their strides.
+        for constructor in _iter_constructors():
+            t = torch.rand(3, 4).t()
+            nt = constructor([t, t[1:]])
+            self.assertEqual(nt.unbind(), [t, t[1:]])
+            self.assertTrue(all(c.is_contiguous() for c in nt.unbind()))
+
         nested_tensor1 = nestedtensor.as_nested_tensor(nested_tensor)
         self.assertTrue(nested_tensor1 is nested_tensor)
         nested_tensor2 = nestedtensor.as_nested_tensor(nested_tensor, dtype=torch.int64)
@@ -216,6 +225,16 @@ class TestNestedTensor(TestCase):
             self.assertEqual(b[0][0], 1)
             self.assertEqual(b[0][1], 2)
 
+            # Dimensions shared by all constiuents are stored only once.
+            a = constructor([torch.randn(3, 2, 4),
+                             torch.randn(5, 2, 4),
+                             torch.randn(3, 2, 1)])
+            self.assertEqual(a.nested_size()[1], torch.Size([5, 2, 4]))
+            self.assertEqual(a.nested_size(1), (3, 5, 3))
+            self.assertEqual(a.nested_size(2), (2, 2, 2))
+            self.assertEqual(a.nested_size(3), (4, 4, 1))
+            self.assertEqual(a.size(), (3, None, 2, None))
+
             a = constructor([[torch.randn(1)], [torch.randn(2), torch.randn(1)]])
             self.assertEqual(a.nested_size()[0][0], torch.Size([1]))
             self.assertEqual(a.nested_size()[1][0], torch.Size([2]))
@@ -245,6 +264,26 @@ class TestNestedTensor(TestCase):
             for r, s in zip(result, na):
                 self.assertEqual(r, s)
 
+    def test_nested_size_as_tensor(self):
+        for constructor in _iter_constructors():
+            a = constructor([torch.randn(3, 2), torch.randn(5, 2)])
+            self.assertEqual(a.nested_size(as_tensor=True),
+                             torch.tensor([[3, 2], [5, 2]]))
+            self.assertEqual(a.nested_stride(as_tensor=True),
+                             torch.tensor([[2, 1], [2, 1]]))
+            self.assertRaises(ValueError, lambda: a.nested_size(1, as_tensor=True))
+
+            a = constructor([[torch.randn(1)],
+                             [torch.randn(2), torch.randn(3)],
+                             []])
+            sizes, offsets = a.nested_size(as_tensor=True)
+            self.assertEqual(sizes, torch.tensor([[1], [2], [3]]))
+            self.assertEqual(len(offsets), 1)
+            self.assertEqual(offsets[0], torch.tensor([0, 1, 3, 3]))
+
+            a = constructor([])
+            self.assertEqual(a.nested_size(as_tensor=True).numel(), 0)
+
     def test_len(self):
         for constructor in _iter_constructors():
             a = constructor([torch.tensor([1, 2]),
@@ -430,6 +469,10 @@ class TestNestedTensor(TestCase):
             self.assertRaises(IndexError, lambda: a.to_tensor(1))
             self.assertRaises(IndexError, lambda: a.to_tensor(2))
 
+            a = constructor([[], []])
+            self.assertEqual(a.to_tensor(), torch.empty(2, 0))
+            self.assertEqual(a.to_tensor(0), torch.empty(2, 0))
+
             a = constructor([torch.tensor(1)])
             self.assertEqual(a.to_tensor(), torch.tensor([1]))
             self.assertEqual(a.to_tensor(0), torch.tensor([1]))
@@ -563,6 +606,101 @@ class TestNestedTensor(TestCase):
         a1 = nestedtensor.nested_tensor(tensors, requires_grad=True)
         self.assertRaises(RuntimeError, lambda: a1.grad)
 
+    def test_builder(self):
+        builder = nestedtensor.NestedTensorBuilder()
+        self.assertEqual(builder.finish(), nestedtensor.nested_tensor([]))
+
+        tensors = [torch.rand(i + 1, 3) for i in range(20)]
+        for t in tensors:
+            builder.append(t)
+        self.assertEqual(len(builder), 20)
+        nt = builder.finish()
+        self.assertEqual(len(builder), 0)
+        self.assertEqual(nt, nestedtensor.nested_tensor(tensors))
+        data_ptrs = set(t.storage().data_ptr() for t in nt.unbind())
+        self.assertEqual(len(data_ptrs), 1)
+
+        # The result doesn't share memory with the builder's next result.
+        builder.append(torch.zeros(2, 3))
+        builder.reserve(100)
+        builder.append(torch.zeros(4, 3))
+        nt1 = builder.finish()
+        self.assertEqual(nt, nestedtensor.nested_tensor(tensors))
+        self.assertEqual(nt1, nestedtensor.nested_tensor(
+            [torch.zeros(2, 3), torch.zeros(4, 3)]))
+
+        # A result that uses little of the buffer doesn't keep all of it alive.
+        t = torch.rand(2, 3)
+        builder.append(t)
+        builder.reserve(1 << 16)
+        nt1 = builder.finish()
+        self.assertEqual(nt1, nestedtensor.nested_tensor([t]))
+        self.assertEqual(nt1.unbind()[0].storage().size(), 6)
+
+        builder.append(torch.rand(2, 3))
+        self.assertRaises(RuntimeError, lambda: builder.append(torch.rand(2)))
+        self.assertRaises(RuntimeError, lambda: builder.append(
+            torch.rand(2, 3).to(torch.int64)))
+        self.assertRaises(RuntimeError, lambda: builder.append(
+            nestedtensor.nested_tensor([torch.rand(2, 3)])._impl))
+
+    def test_save_load(self):
+        for constructor in _iter_constructors():
+            for data in [[],
+                         [torch.tensor(1), torch.tensor(2)],
+                         [torch.rand(2, 3), torch.rand(4, 3)],
+                         [[torch.rand(1, 8), torch.rand(3, 8)], [], [torch.rand(7, 8)]]]:
+                nt = constructor(data)
+                with tempfile.TemporaryDirectory() as tmp_dir:
+                    path = os.path.join(tmp_dir, "nt.bin")
+                    nestedtensor.save(nt, path)
+                    nt1 = nestedtensor.load(path)
+                    self.assertEqual(nt.nested_dim(), nt1.nested_dim())
+                    self.assertEqual(nt.nested_size(), nt1.nested_size())
+                    self.assertEqual(nt, nt1)
+
+        tensors = [torch.randint(100, (i + 1, 4)) for i in range(5)]
+        nt = nestedtensor.nested_tensor(tensors)
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, "nt.bin")
+            nestedtensor.save(nt, path)
+            nt1 = nestedtensor.load(path)
+            self.assertEqual(nt1.dtype, torch.int64)
+            # All constiuents are views into the same mapping.
+            data_ptrs = set(t.storage().data_ptr() for t in nt1.unbind())
+            self.assertEqual(len(data_ptrs), 1)
+            # In-place modifications don't reach the file.
+            nt1.add_(nt1)
+            nt2 = nestedtensor.load(path)
+            self.assertEqual(nt, nt2)
+            self.assertEqual(nt + nt, nt1)
+
+            # Header fields that overflow once multiplied or added up.
+            import struct
+            with open(path, "rb") as f:
+                data = bytearray(f.read())
+            # Fields after the magic: version, scalar_type, nested_dim,
+            # tensor_dim, num_nodes, num_leaves, data_offset, data_numel.
+            for field, value in [(7, 2 ** 61), (5, 2 ** 62), (3, 2 ** 63 - 1)]:
+                corrupted = bytearray(data)
+                struct.pack_into("<q", corrupted, 8 + 8 * field, value)
+                with open(path, "wb") as f:
+                    f.write(corrupted)
+                self.assertRaises(RuntimeError, lambda: nestedtensor.load(path))
+
+            with open(path, "wb") as f:
+                f.write(b"not a nestedtensor")
+            self.assertRaises(RuntimeError, lambda: nestedtensor.load(path))
+
+            # Without constiuents the dtype and dim come from the header.
+            nt = nestedtensor.nested_tensor([tensors[:2], tensors[2:]])
+            nt = nt.index_select(0, torch.tensor([], dtype=torch.long))
+            nestedtensor.save(nt, path)
+            nt1 = nestedtensor.load(path)
+            self.assertEqual(nt1.nested_dim(), 2)
+            self.assertEqual(nt1.dim(), 4)
+            self.assertEqual(nt1.dtype, torch.int64)
+
     @unittest.skipIf(not torch.cuda.is_available(), "CUDA not enabled.")
     def test_pin_memory(self):
         # Check if it can be applied widely
@@ -594,6 +732,356 @@ class TestNestedTensor(TestCase):
         self.assertFalse(a5.is_pinned())
         self.assertFalse(a6.is_pinned())
 
+    def test_slice(self):
+        tensors = [torch.rand(i + 1, 3) for i in range(6)]
+        nt = nestedtensor.nested_tensor(tensors)
+        self.assertEqual(nt[-1], tensors[-1])
+        self.assertEqual(nt.select(0, 2), tensors[2])
+        self.assertEqual(nt[1:4], nestedtensor.nested_tensor(tensors[1:4]))
+        self.assertEqual(nt[::2], nestedtensor.nested_tensor(tensors[::2]))
+        self.assertEqual(nt[4:100], nestedtensor.nested_tensor(tensors[4:]))
+        self.assertEqual(nt.narrow(0, 2, 3), nestedtensor.nested_tensor(tensors[2:5]))
+        self.assertEqual(nt.narrow(1, 0, 1), nestedtensor.nested_tensor(
+            [t.narrow(0, 0, 1) for t in tensors]))
+        self.assertRaises(RuntimeError, lambda: nt.narrow(0, 4, 3))
+
+        # Slices share their constiuents with the original.
+        nt_slice = nt[2:4]
+        nt_slice.unbind()[1].fill_(0)
+        self.assertEqual(nt.unbind()[3], torch.zeros(4, 3))
+
+        nt = nestedtensor.nested_tensor([tensors[:2], tensors[2:]])
+        self.assertEqual(nt[1], nestedtensor.nested_tensor(tensors[2:]))
+        self.assertEqual(nt.narrow(1, 1, 1), nestedtensor.nested_tensor(
+            [tensors[1:2], tensors[3:4]]))
+
+        # Empty results keep the dtype and dim.
+        nt = nestedtensor.nested_tensor([tensors[:2], tensors[2:]], dtype=torch.float64)
+        for empty in [nt[1:1], nt[2:], nt[1:1:2], nt.narrow(0, 1, 0), nt.narrow(1, 0, 0)]:
+            self.assertEqual(empty.nested_dim(), 2)
+            self.assertEqual(empty.dim(), nt.dim())
+            self.assertEqual(empty.dtype, torch.float64)
+
+    def test_index_select(self):
+        tensors = [torch.rand(i + 1, 3) for i in range(5)]
+        nt = nestedtensor.nested_tensor(tensors)
+        index = torch.tensor([4, 0, 2, 0])
+        expected = nestedtensor.nested_tensor([tensors[i] for i in index.tolist()])
+        self.assertEqual(nt.index_select(0, index), expected)
+        self.assertEqual(torch.index_select(nt, 0, index), expected)
+        self.assertEqual(nt[index], expected)
+        self.assertEqual(nt[torch.tensor([-1])], nestedtensor.nested_tensor(tensors[-1:]))
+        self.assertRaises(IndexError, lambda: nt.index_select(0, torch.tensor([5])))
+        self.assertRaises(RuntimeError, lambda: nt.index_select(1, index))
+
+        # The result is a copy.
+        result = nt.index_select(0, index)
+        result.unbind()[1].fill_(0)
+        self.assertEqual(nt.unbind()[0], tensors[0])
+
+        nt = nestedtensor.nested_tensor([tensors[:2], tensors[2:]])
+        self.assertEqual(nt.index_select(0, torch.tensor([1, 1])),
+                         nestedtensor.nested_tensor([tensors[2:], tensors[2:]]))
+
+        # An empty selection keeps the nested_dim and dim.
+        empty = nt.index_select(0, torch.tensor([], dtype=torch.long))
+        self.assertEqual(len(empty), 0)
+        self.assertEqual(empty.nested_dim(), nt.nested_dim())
+        self.assertEqual(empty.dim(), nt.dim())
+        self.assertEqual(empty.dtype, nt.dtype)
+
+    def test_sort_by_size(self):
+        lengths = [5, 2, 7, 2, 1]
+        tensors = [torch.rand(l, 3) for l in lengths]
+        nt = nestedtensor.nested_tensor(tensors)
+        nt_sorted, inverse = nestedtensor.sort_by_size(nt, dim=1)
+        # Stable, so the two entries of length 2 keep their order.
+        order = [4, 1, 3, 0, 2]
+        self.assertEqual(nt_sorted, nestedtensor.nested_tensor([tensors[i] for i in order]))
+        self.assertEqual(nt_sorted.index_select(0, inverse), nt)
+        nt_sorted, inverse = nestedtensor.sort_by_size(nt, dim=1, descending=True)
+        order = [2, 0, 1, 3, 4]
+        self.assertEqual(nt_sorted, nestedtensor.nested_tensor([tensors[i] for i in order]))
+        self.assertEqual(nt_sorted.index_select(0, inverse), nt)
+        self.assertRaises(RuntimeError, lambda: nestedtensor.sort_by_size(nt, dim=0))
+        # Sorts by length by default.
+        nt_sorted, inverse = nestedtensor.sort_by_size(nt)
+        self.assertEqual(nt_sorted, nestedtensor.nested_tensor(
+            [tensors[i] for i in [4, 1, 3, 0, 2]]))
+
+    def test_bucketize_by_size(self):
+        lengths = [5, 2, 7, 2, 1, 9]
+        tensors = [torch.rand(l, 3) for l in lengths]
+        nt = nestedtensor.nested_tensor(tensors)
+        buckets = nestedtensor.bucketize_by_size(nt, [2, 4, 6], dim=1)
+        # The bucket for sizes in (2, 4] is empty and dropped.
+        expected = [[1, 3, 4], [0], [2, 5]]
+        self.assertEqual(len(buckets), len(expected))
+        for (bucket, index), e in zip(buckets, expected):
+            self.assertEqual(index, torch.tensor(e))
+            self.assertEqual(bucket, nestedtensor.nested_tensor([tensors[i] for i in e]))
+        self.assertEqual([index for _, index in nestedtensor.bucketize_by_size(nt, [2, 4, 6])],
+                         [torch.tensor(e) for e in expected])
+
+    def test_quantize(self):
+        tensors = [torch.randn(3, 8), torch.randn(1, 8) * 10, torch.randn(5, 8)]
+        nt = nestedtensor.nested_tensor(tensors)
+        weight = torch.randn(8, 4)
+        for per_row in [False, True]:
+            q = nestedtensor.quantize(nt, per_row=per_row)
+            self.assertEqual(q.data.dtype, torch.int8)
+            self.assertEqual(q.nested_size(), nt.nested_size())
+            self.assertEqual(q.scale.numel(), 9 if per_row else 3)
+            result = q.dequantize()
+            for t, r, s in zip(tensors, result.unbind(), q.scale.split([3, 1, 5] if per_row else 1)):
+                self.assertTrue((t - r).abs().max() <= s.max() * 0.51)
+            mm = q.matmul(weight)
+            for r, m in zip(result.unbind(), mm.unbind()):
+                self.assertTrue(torch.allclose(r.matmul(weight), m, rtol=1e-4, atol=1e-3))
+        self.assertRaises(RuntimeError, lambda: nestedtensor.quantize(
+            nestedtensor.nested_tensor([torch.tensor([1, 2])])))
+        self.assertRaises(RuntimeError, lambda: q.matmul(torch.randn(4, 4)))
+
+        # As many rows as constiuents, so only per_row tells them apart.
+        tensors = [torch.randn(0, 8), torch.randn(2, 8) * torch.tensor([[1.], [100.]])]
+        nt = nestedtensor.nested_tensor(tensors)
+        q = nestedtensor.quantize(nt, per_row=True)
+        self.assertEqual(q.scale.numel(), 2)
+        result = q.dequantize()
+        self.assertTrue((tensors[1][0] - result.unbind()[1][0]).abs().max() <= q.scale[0] * 0.51)
+        mm = q.matmul(weight)
+        self.assertTrue(torch.allclose(result.unbind()[1].matmul(weight), mm.unbind()[1],
+                                       rtol=1e-4, atol=1e-3))
+        self.assertRaises(RuntimeError, lambda: nestedtensor.QuantizedNestedTensor(
+            q.data, q.scale[:1], q.zero_point[:1], per_row=True).dequantize())
+
+    def test_to_padded_tensor(self):
+        t_a = torch.randn(2, 3)
+        t_b = torch.randn(1, 4)
+        t_c = torch.randn(3, 1)
+        nt = nestedtensor.nested_tensor([[t_a, t_b], [t_c]])
+        expected = torch.full((2, 2, 3, 4), -1.)
+        expected[0, 0, :2, :3] = t_a
+        expected[0, 1, :1, :4] = t_b
+        expected[1, 0, :3, :1] = t_c
+        self.assertEqual(nt.to_padded_tensor(), expected)
+        expected = expected.masked_fill(expected == -1, 0)
+        self.assertEqual(nt.to_padded_tensor(padding=0), expected)
+
+        nt = nestedtensor.nested_tensor([[t_a, t_a], [t_a, t_a]])
+        self.assertEqual(nt.to_padded_tensor(), nt.to_tensor())
+
+    def test_jit_apply(self):
+        @torch.jit.script
+        def fn(x):
+            return (x + 1).abs()
+
+        tensors = [torch.randn(2, 3), torch.randn(4, 3), torch.randn(2, 3)]
+        nt = nestedtensor.nested_tensor([tensors[:2], tensors[2:]])
+        for batch in [False, True]:
+            result = nt.jit_apply(fn, batch=batch)
+            self.assertEqual(result.nested_dim(), 2)
+            self.assertEqual(result, nestedtensor.nested_tensor(
+                [[fn(t) for t in tensors[:2]], [fn(tensors[2])]]))
+
+        @torch.jit.script
+        def reduce_fn(x):
+            return x.sum()
+
+        self.assertRaises(RuntimeError, lambda: nt.jit_apply(reduce_fn, batch=True))
+
+    def test_method_dispatch(self):
+        tensors = [torch.rand(i + 1, 4) for i in range(3)]
+        nt = nestedtensor.nested_tensor(tensors)
+        result = nt.mul(nt)
+        self.assertTrue(isinstance(result, nestedtensor.NestedTensor))
+        # Methods are cached on the class after the first use.
+        self.assertTrue("mul" in nestedtensor.NestedTensor.__dict__)
+        result = nt.mul(nt)
+        for t, r in zip(tensors, result.unbind()):
+            self.assertEqual(t * t, r)
+        result = torch.mul(nt, nt)
+        self.assertTrue(isinstance(result, nestedtensor.NestedTensor))
+        for t, r in zip(tensors, result.unbind()):
+            self.assertEqual(t * t, r)
+        # Non-Tensor results are passed through unchanged.
+        self.assertEqual(nt.dim(), 3)
+        self.assertEqual(nt.is_contiguous(), True)
+
+    def test_op_stats(self):
+        torch.ops.nestedtensor.reset_stats()
+        nt = nestedtensor.nested_tensor([torch.rand(i + 1, 4) for i in range(3)])
+        nt.cos()
+        stats = torch.ops.nestedtensor.stats()["NestedTensor_cos"]
+        self.assertEqual(stats["calls"], 1)
+        self.assertEqual(stats["leaves"], 3)
+        self.assertEqual(stats["fallbacks"], 0)
+
+        # Constiuents that require gradients can't be packed.
+        nt.requires_grad_(True)
+        nt.cos()
+        stats = torch.ops.nestedtensor.stats()["NestedTensor_cos"]
+        self.assertEqual(stats["calls"], 2)
+        self.assertEqual(stats["leaves"], 6)
+        self.assertEqual(stats["fallbacks"], 1)
+
+        torch.ops.nestedtensor.reset_stats()
+        self.assertTrue("NestedTensor_cos" not in torch.ops.nestedtensor.stats())
+
+    def test_concurrent_reads(self):
+        import threading
+        tensors = [torch.rand(i + 2, 4) for i in range(8)]
+        nt = nestedtensor.nested_tensor(tensors)
+        weight = torch.rand(4, 3)
+        ops = [
+            lambda x: x.cos(),
+            lambda x: x + x,
+            lambda x: torch.nn.functional.softmax(x, 2),
+            lambda x: torch.matmul(x, weight),
+            lambda x: x.squeeze(),
+        ]
+        expected = [op(nt) for op in ops]
+        errors = []
+
+        def read():
+            try:
+                for _ in range(50):
+                    for op, result in zip(ops, expected):
+                        self.assertEqual(op(nt), result)
+                    self.assertEqual(nt.nested_size(), expected[0].nested_size())
+                    self.assertEqual(nt.size(), expected[0].size())
+            except Exception as e:
+                errors.append(e)
+
+        def write():
+            # Each call publishes a new version with the same sizes while the
+            # readers run.
+            for i in range(200):
+                nt.requires_grad_(i % 2 == 0)
+                nt.squeeze_()
+
+        threads = [threading.Thread(target=read) for _ in range(4)]
+        threads.append(threading.Thread(target=write))
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+        for t, r in zip(tensors, nt.unbind()):
+            self.assertEqual(t, r)
+
+        # requires_grad_ replaces the constiuents instead of modifying the
+        # ones shared with other NestedTensors.
+        shared = nt.squeeze()
+        nt.requires_grad_()
+        self.assertTrue(nt.requires_grad)
+        self.assertFalse(shared.requires_grad)
+        self.assertFalse(any(t.requires_grad for t in shared.unbind()))
+
+    def test_dynamic_batcher(self):
+        import threading
+        # Token budget
+        batcher = nestedtensor.DynamicBatcher(10, 1e6)
+        tensors = [torch.rand(i + 1, 3) for i in range(5)]
+        requests = [batcher.submit(t) for t in tensors]
+        self.assertEqual(batcher.pending(), 5)
+        batch = batcher.next_batch()
+        self.assertEqual(batch.input, nestedtensor.nested_tensor(tensors[:4]))
+        data_ptrs = set(t.storage().data_ptr() for t in batch.input.unbind())
+        self.assertEqual(len(data_ptrs), 1)
+        self.assertFalse(requests[0].done())
+        self.assertEqual(requests[0].wait(timeout_ms=1), None)
+        batch.complete(batch.input * 2)
+        for t, r in zip(tensors[:4], requests[:4]):
+            self.assertEqual(r.wait(), t * 2)
+        # Only the deadline or close() hand out the last request.
+        self.assertEqual(batcher.next_batch(timeout_ms=10), None)
+        batcher.close()
+        self.assertRaises(RuntimeError, lambda: batcher.submit(tensors[0]))
+        batch = batcher.next_batch()
+        self.assertEqual(len(batch), 1)
+        batch.complete(torch.stack([t.sum() for t in batch.input.unbind()]))
+        self.assertEqual(requests[4].wait(), tensors[4].sum())
+        self.assertEqual(batcher.next_batch(), None)
+
+        # Deadline and max_batch_size
+        batcher = nestedtensor.DynamicBatcher(1000, 5, max_batch_size=2)
+        requests = [batcher.submit(t) for t in tensors[:3]]
+        self.assertEqual(len(batcher.next_batch(timeout_ms=1000)), 2)
+        batch = batcher.next_batch(timeout_ms=1000)
+        self.assertEqual(len(batch), 1)
+        batch.fail("failed")
+        self.assertRaises(RuntimeError, lambda: requests[2].wait())
+        # Requests that don't match the batch fail on their own.
+        requests = [batcher.submit(tensors[0]), batcher.submit(torch.rand(3))]
+        batch = batcher.next_batch(timeout_ms=1000)
+        self.assertEqual(len(batch), 1)
+        self.assertRaises(RuntimeError, lambda: requests[1].wait())
+        self.assertRaises(RuntimeError, lambda: batch.complete(torch.rand(2)))
+
+        # A result that can't be scattered fails its batch, but the server
+        # keeps serving.
+        batcher = nestedtensor.DynamicBatcher(64, 2, 1)
+        calls = []
+
+        def fn(x):
+            calls.append(x)
+            return torch.tensor(0.) if len(calls) == 1 else x + 1
+        server = threading.Thread(target=batcher.serve, args=(fn,))
+        server.start()
+        request = batcher.submit(tensors[0])
+        self.assertRaises(RuntimeError, lambda: request.wait())
+        request = batcher.submit(tensors[0])
+        self.assertEqual(request.wait(), tensors[0] + 1)
+        batcher.close()
+        server.join()
+
+        # Synthetic load from several threads
+        batcher = nestedtensor.DynamicBatcher(64, 2)
+        server = threading.Thread(target=batcher.serve, args=(lambda x: x + 1,))
+        server.start()
+        results = {}
+
+        def client(i):
+            inputs = [torch.rand(random.randint(1, 16), 3) for _ in range(20)]
+            requests = [batcher.submit(t) for t in inputs]
+            results[i] = all((r.wait() == t + 1).all() for t, r in zip(inputs, requests))
+
+        clients = [threading.Thread(target=client, args=(i,)) for i in range(4)]
+        for c in clients:
+            c.start()
+        for c in clients:
+            c.join()
+        batcher.close()
+        server.join()
+        self.assertEqual(results, {i: True for i in range(4)})
+
+        # Every request that submit accepted while racing close is served.
+        for _ in range(20):
+            batcher = nestedtensor.DynamicBatcher(64, 1)
+            server = threading.Thread(target=batcher.serve, args=(lambda x: x + 1,))
+            server.start()
+            accepted = {}
+
+            def submitter(i):
+                accepted[i] = []
+                while True:
+                    t = torch.rand(random.randint(1, 4), 3)
+                    try:
+                        accepted[i].append((t, batcher.submit(t)))
+                    except RuntimeError:
+                        return
+
+            submitters = [threading.Thread(target=submitter, args=(i,)) for i in range(4)]
+            for s in submitters:
+                s.start()
+            batcher.close()
+            for s in submitters:
+                s.join()
+            server.join()
+            for t, r in sum(accepted.values(), []):
+                self.assertEqual(r.wait(timeout_ms=10000), t + 1)
+            self.assertEqual(batcher.pending(), 0)
 
 class TestContiguous(TestCase):
     def test_contiguous(self):
@@ -614,6 +1102,37 @@ class TestContiguous(TestCase):
                                            torch.tensor([7, 8])])
         self.assertTrue(a.is_contiguous())
 
+    def test_arena(self):
+        torch.ops.nestedtensor.arena_empty_cache()
+        torch.ops.nestedtensor.arena_reset_stats()
+        tensors = [torch.rand(i + 1, 16) for i in range(8)]
+        nt = nestedtensor.nested_tensor(tensors)
+        stats = torch.ops.nestedtensor.arena_stats()
+        self.assertEqual(stats["blocks_reserved"], 1)
+        self.assertEqual(stats["blocks_reused"], 0)
+
+        # All constiuents of a result share a single block.
+        nt_cos = nt.cos()
+        data_ptrs = set(t.storage().data_ptr() for t in nt_cos.unbind())
+        self.assertEqual(len(data_ptrs), 1)
+        for t, t_cos in zip(tensors, nt_cos.unbind()):
+            self.assertEqual(t.cos(), t_cos)
+
+        # The block goes back to the pool once the last view dies.
+        del t_cos
+        del nt_cos
+        nt_cos = nt.cos()
+        stats = torch.ops.nestedtensor.arena_stats()
+        self.assertEqual(stats["blocks_reserved"], 2)
+        self.assertEqual(stats["blocks_reused"], 1)
+        self.assertEqual(stats["bytes_reused"] > 0, True)
+
+        # Constiuents that require gradients keep their own allocations.
+        nt.requires_grad_(True)
+        nt_cos = nt.cos()
+        data_ptrs = set(t.storage().data_ptr() for t in nt_cos.unbind())
+        self.assertEqual(len(data_ptrs), len(tensors))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -105,6 +105,64 @@ class TestFunctional(TestCase):
                 nt, weight, bias, (2, 2), (3, 3), (1, 1), 1).unbind()]
             self.assertEqual(nt_res, tensor_res)
 
+    def test_nn_functional_conv1d(self):
+        inputs = [torch.randn(4, 9), torch.randn(4, 3), torch.randn(4, 17)]
+        weight = torch.randn(6, 2, 3)
+        bias = torch.randn(6)
+        for stride, padding, dilation in [(1, 0, 1), (2, 1, 1), (3, 2, 2)]:
+            for padding_mode in ['zeros', 'reflect', 'replicate', 'circular']:
+                if padding_mode != 'zeros' and padding == 0:
+                    continue
+                nt = nestedtensor.nested_tensor(inputs)
+                result = nestedtensor.nn.conv1d(
+                    nt, weight, bias, stride, padding, dilation, 2, padding_mode)
+                for t, r in zip(inputs, result.unbind()):
+                    if padding_mode == 'zeros':
+                        t = F.pad(t.unsqueeze(0), (padding, padding))
+                    else:
+                        t = F.pad(t.unsqueeze(0), (padding, padding), mode=padding_mode)
+                    self.assertEqual(F.conv1d(t, weight, bias, stride, 0, dilation, 2).squeeze(0), r)
+            for nt in [nestedtensor.nested_tensor(inputs), nestedtensor.as_nested_tensor(inputs)]:
+                self.assertEqual(
+                    F.conv1d(nt, weight, bias, stride, padding, dilation, 2),
+                    nestedtensor.nested_tensor(
+                        [F.conv1d(t.unsqueeze(0), weight, bias, stride, padding, dilation, 2).squeeze(0)
+                         for t in inputs]))
+
+        self.assertRaises(RuntimeError, lambda: nestedtensor.nn.conv1d(
+            nestedtensor.nested_tensor(inputs), weight, bias, stride=0, groups=2))
+        self.assertRaises(RuntimeError, lambda: nestedtensor.nn.conv1d(
+            nestedtensor.nested_tensor([torch.randn(4, 5), torch.randn(2, 5)]),
+            weight, bias, groups=2))
+
+        # Backward
+        inputs = [t.clone().requires_grad_() for t in inputs]
+        weight.requires_grad_()
+        result = F.conv1d(nestedtensor.as_nested_tensor(inputs), weight, None, 1, 1, 1, 2)
+        sum((r * r).sum() for r in result.unbind()).backward()
+        grads = [t.grad for t in inputs] + [weight.grad]
+        self.assertTrue(all(g is not None for g in grads))
+        for t in inputs + [weight]:
+            t.grad = None
+        sum((r * r).sum() for r in [F.conv1d(t.unsqueeze(0), weight, None, 1, 1, 1, 2)
+                                    for t in inputs]).backward()
+        self.assertEqual(grads, [t.grad for t in inputs] + [weight.grad])
+
+    def test_nn_functional_conv2d_buckets(self):
+        # Constiuents of equal size are stacked and run as one batch.
+        sizes = [(3, 16, 16), (3, 8, 12), (3, 16, 16), (3, 8, 12), (3, 16, 16)]
+        inputs = [torch.rand(*size) for size in sizes]
+        weight = torch.rand(4, 3, 3, 3)
+        bias = torch.rand(4)
+        tensor_res = [torch.nn.functional.conv2d(
+            t.unsqueeze(0), weight, bias).squeeze(0) for t in inputs]
+        nt = nestedtensor.nested_tensor([inputs[:2], inputs[2:]])
+        # Twice to also hit the plan cached on nt.
+        for _ in range(2):
+            nt_res = torch.nn.functional.conv2d(nt, weight, bias)
+            self.assertEqual(nestedtensor.nested_tensor(
+                [tensor_res[:2], tensor_res[2:]]), nt_res)
+
     def test_nn_batch_norm(self):
         inputs = [
             torch.tensor([[[-0.5000]], [[0.5000]]]),
@@ -298,6 +356,79 @@ class TestFunctional(TestCase):
             self.assertEqual(nestedtensor.nested_tensor(
                 tensor_res).size(), nt_res.size())
 
+    def test_fused_dropout(self):
+        ts = [torch.randn(30, 70), torch.randn(50, 70), torch.randn(1, 70)]
+        p = 0.3
+        nt = nestedtensor.nested_tensor(ts)
+        result, seed = nestedtensor.dropout(nt, p)
+        mask = nestedtensor.dropout_mask(nt, p, seed)
+        for t, r, m in zip(ts, result.unbind(), mask.unbind()):
+            self.assertEqual(m.dtype, torch.bool)
+            self.assertEqual(r, t * m / (1 - p))
+        kept = sum(m.sum().item() for m in mask.unbind()) / nt.numel()
+        self.assertTrue(abs(kept - (1 - p)) < 0.05)
+
+        # The mask only depends on the seed and the packed layout, not on how
+        # the constiuents are stored or nested.
+        def flat(x):
+            if isinstance(x, torch.Tensor):
+                return x.flatten()
+            return torch.cat([flat(x_i) for x_i in x.unbind()])
+        for other in [nestedtensor.as_nested_tensor(ts),
+                      nestedtensor.nested_tensor([ts[:2], ts[2:]])]:
+            other_result, _ = nestedtensor.dropout(other, p, seed)
+            self.assertEqual(flat(result), flat(other_result))
+        nt_ = nestedtensor.as_nested_tensor([t.clone() for t in ts])
+        torch.manual_seed(0)
+        F.dropout(nt_, p, inplace=True)
+        torch.manual_seed(0)
+        self.assertEqual(nt_, F.dropout(nt, p))
+        self.assertEqual(F.dropout(nt, p, training=False), nt)
+
+        # Backward applies the same mask, which is recomputed from the seed.
+        inputs = [t.clone().requires_grad_() for t in ts]
+        result, seed = nestedtensor.dropout(nestedtensor.as_nested_tensor(inputs), p)
+        self.assertEqual(flat(result), flat(nestedtensor.dropout(nt, p, seed)[0]))
+        sum((r * 2).sum() for r in result.unbind()).backward()
+        for t, m in zip(inputs, nestedtensor.dropout_mask(nt, p, seed).unbind()):
+            self.assertEqual(t.grad, m * 2 / (1 - p))
+        torch.ops.nestedtensor.reset_stats()
+        F.dropout(nestedtensor.as_nested_tensor(inputs), p).unbind()
+        self.assertEqual(torch.ops.nestedtensor.stats()["NestedTensor_dropout"]["fallbacks"], 0)
+
+    def test_packed_sequence(self):
+        from torch.nn.utils.rnn import pack_sequence, pad_packed_sequence
+        # Distinct lengths, so that the sort order doesn't depend on ties.
+        ts = [torch.randn(3, 4), torch.randn(5, 4), torch.randn(1, 4), torch.randn(4, 4)]
+        for nt in [nestedtensor.nested_tensor(ts), nestedtensor.as_nested_tensor(ts)]:
+            packed = nestedtensor.to_packed_sequence(nt)
+            expected = pack_sequence(ts, enforce_sorted=False)
+            self.assertEqual(packed.data, expected.data)
+            self.assertEqual(packed.batch_sizes, expected.batch_sizes)
+            self.assertEqual(packed.sorted_indices, expected.sorted_indices)
+            self.assertEqual(nestedtensor.from_packed_sequence(packed), nt)
+            self.assertEqual(nestedtensor.from_packed_sequence(expected), nt)
+        self.assertRaises(RuntimeError, lambda: nestedtensor.to_packed_sequence(
+            nestedtensor.nested_tensor([torch.randn(2, 3), torch.randn(2, 4)])))
+        expected = pack_sequence(ts, enforce_sorted=False)
+        for indices in [torch.tensor([0, 1, 2, 4]), torch.tensor([0, 1, 2, 3, 0]),
+                        torch.tensor([0, 1, 1, 2])]:
+            self.assertRaises(RuntimeError, lambda: nestedtensor.from_packed_sequence(
+                expected._replace(sorted_indices=indices, unsorted_indices=None)))
+            self.assertRaises(RuntimeError, lambda: nestedtensor.from_packed_sequence(
+                expected._replace(unsorted_indices=indices)))
+
+        nt = nestedtensor.nested_tensor(ts)
+        for module, fn in [(torch.nn.LSTM(4, 6, num_layers=2, bidirectional=True),
+                            nestedtensor.nn.lstm),
+                           (torch.nn.GRU(4, 6), nestedtensor.nn.gru)]:
+            output, h = fn(module, nt)
+            expected_output, expected_h = module(pack_sequence(ts, enforce_sorted=False))
+            padded, lengths = pad_packed_sequence(expected_output)
+            for i, o in enumerate(output.unbind()):
+                self.assertEqual(o, padded[:lengths[i], i])
+            self.assertEqual(h, expected_h)
+
     def test_nn_functional_interpolate(self):
         inputs = [
             torch.randn(3, 200, 300),
@@ -380,6 +511,46 @@ class TestFunctional(TestCase):
             nt1.copy_(nt2)
             self.assertEqual(nt1, nt2)
 
+    def test_dense_batches(self):
+        ts = [[torch.randn(3, 4), torch.randn(3, 4)],
+              [torch.randn(3, 4), torch.randn(3, 4)]]
+        nt = nestedtensor.nested_tensor(ts)
+        weight = torch.randn(4, 5)
+        fns = [lambda x: x.cos(),
+               lambda x: x + x,
+               lambda x: F.softmax(x, -1),
+               lambda x: F.layer_norm(x, (4,)),
+               lambda x: torch.matmul(x, weight)]
+        for fn in fns:
+            result = fn(nt)
+            # Results of regular batches stay packed.
+            data_ptrs = set(t.storage().data_ptr()
+                            for t in result.unbind()[0].unbind() + result.unbind()[1].unbind())
+            self.assertEqual(len(data_ptrs), 1)
+            for t_i, r_i in zip(ts, result.unbind()):
+                for t, r in zip(t_i, r_i.unbind()):
+                    self.assertEqual(fn(t), r)
+
+        nt = nestedtensor.nested_tensor(
+            [torch.randn(2, 8, 8), torch.randn(2, 8, 8)])
+        conv_weight = torch.randn(3, 2, 3, 3)
+        result = F.conv2d(nt, conv_weight)
+        for t, r in zip(nt.unbind(), result.unbind()):
+            self.assertEqual(F.conv2d(t.unsqueeze(0), conv_weight).squeeze(0), r)
+
+    def test_packed_views(self):
+        ts = [torch.randn(2, 1, 6), torch.randn(3, 1, 6)]
+        nt = nestedtensor.nested_tensor(ts)
+        data_ptr = nt.unbind()[0].storage().data_ptr()
+        for result, fn in [(nt.squeeze(2), lambda t: t.squeeze(1)),
+                           (nt.reshape(-1, -1, 2, 3), lambda t: t.reshape(-1, 2, 3)),
+                           (nt.flatten(2), lambda t: t.flatten(1))]:
+            self.assertTrue(result.is_contiguous())
+            for t, r in zip(ts, result.unbind()):
+                self.assertEqual(fn(t), r)
+                # Only metadata changes, the data is shared.
+                self.assertEqual(r.storage().data_ptr(), data_ptr)
+
     def test_squeeze(self):
         for constructor in _iter_constructors():
             t = torch.randn(2, 3)
@@ -475,11 +646,11 @@ class TestFunctional(TestCase):
         t2 = torch.randn(3, 3, 2)
         ts = [[t0, t1], [t2]]
         nt = nestedtensor.nested_tensor(ts)
-        self.assertRaisesRegex(RuntimeError, "Transposition of nested dimensions is not implemented yet.",
+        self.assertRaisesRegex(RuntimeError, "Cannot transpose a nested dimension with a tensor dimension",
                                lambda: nt.transpose(0, 2))
-        self.assertRaisesRegex(RuntimeError, "Transposition of nested dimensions is not implemented yet.",
+        self.assertRaisesRegex(RuntimeError, "Cannot transpose a nested dimension with a tensor dimension",
                                lambda: nt.transpose(1, 3))
-        self.assertRaisesRegex(RuntimeError, "Transposition of nested dimensions is not implemented yet.",
+        self.assertRaisesRegex(RuntimeError, "Cannot transpose nested dimensions 0 and 1",
                                lambda: nt.transpose(0, 1))
         self.assertEqual(nt.transpose(2, 3), nt.transpose(3, 2))
         t = torch.randn(2, 3, 2, 4, 1)
@@ -490,6 +661,28 @@ class TestFunctional(TestCase):
             list(map(lambda x: x.unbind(), t_t.unbind())))
         self.assertEqual(t_t, nt_t.to_tensor())
 
+    def test_transpose_nested(self):
+        # Swapping nested dimensions only reindexes the constiuents.
+        ts = [[torch.randn(i + 1, 2) for i in range(3)] for _ in range(2)]
+        nt = nestedtensor.nested_tensor(ts)
+        nt_t = nt.transpose(0, 1)
+        self.assertEqual(nt_t, nestedtensor.nested_tensor(
+            [[ts[0][i], ts[1][i]] for i in range(3)]))
+        self.assertEqual(nt_t.transpose(1, 0), nt)
+        nt = nestedtensor.as_nested_tensor(ts)
+        nt_t = nt.transpose(0, 1)
+        self.assertEqual(nt_t.unbind()[2].unbind()[1].data_ptr(), ts[1][2].data_ptr())
+
+        # Nested dimensions with tensor dimensions if the size is regular
+        # below the nested dimension.
+        t = torch.randn(2, 3, 4, 5)
+        nt = nestedtensor.nested_tensor(list(t.unbind()))
+        for dim in range(1, 4):
+            self.assertEqual(nt.transpose(0, dim).to_tensor(), t.transpose(0, dim))
+        nt = nestedtensor.nested_tensor([list(t_i.unbind()) for t_i in t.unbind()])
+        self.assertEqual(nt.transpose(1, 3).to_tensor(), t.transpose(1, 3))
+        self.assertEqual(nt.transpose(0, 2).to_tensor(), t.transpose(0, 2))
+
     def test_flatten(self):
         t0 = torch.randn(3, 3, 4)
         t1 = torch.randn(2, 4, 3)
@@ -595,6 +788,33 @@ class TestFunctional(TestCase):
                                "Currently only singleton tuples of integers supported for layer_norm.",
                                lambda: layer_norm(nt))
 
+    def test_reduced_precision(self):
+        ts = [torch.randn(i, 16) for i in [3, 7, 1]]
+        nt = nestedtensor.nested_tensor(ts)
+        for dtype in [torch.bfloat16, torch.half]:
+            nt_low = nt.to(dtype)
+            self.assertEqual(nt_low.dtype, dtype)
+            for t, t_low in zip(ts, nt_low.unbind()):
+                self.assertEqual(t.to(dtype), t_low)
+            # Results are rounded to dtype, but accumulated in float.
+            ts_ref = [t.to(dtype).float() for t in ts]
+            tol = 1e-2
+            result = F.softmax(nt_low, 2)
+            self.assertEqual(result.dtype, dtype)
+            for t, r in zip(ts_ref, result.unbind()):
+                self.assertTrue(torch.allclose(
+                    F.softmax(t, 1), r.float(), atol=tol))
+            result = F.layer_norm(nt_low, (16,))
+            self.assertEqual(result.dtype, dtype)
+            for t, r in zip(ts_ref, result.unbind()):
+                self.assertTrue(torch.allclose(
+                    F.layer_norm(t, (16,)), r.float(), atol=5 * tol))
+            result = nt_low.sum()
+            self.assertEqual(result.dtype, dtype)
+            expected = sum(t.sum() for t in ts_ref)
+            self.assertTrue(torch.allclose(
+                expected, result.float(), rtol=tol, atol=tol))
+
     def _test_softmax(self, ts, nt):
         fn = F.softmax
         self.assertRaises(RuntimeError, lambda: fn(nt, 0))
@@ -637,6 +857,63 @@ class TestFunctional(TestCase):
         nt = nestedtensor.nested_tensor(ts)
         self._test_softmax(ts, nt)
 
+    def test_segmented_scan(self):
+        ts = [[torch.randn(3, 4), torch.randn(5, 4)], [torch.randn(1, 4)]]
+        for nt in [nestedtensor.nested_tensor(ts),
+                   nestedtensor.as_nested_tensor(ts)]:
+            for dim in [2, 3, -1, -2]:
+                for fn in [torch.cumsum, torch.cumprod, torch.logcumsumexp]:
+                    result = fn(nt, dim)
+                    for ts_i, r_i in zip(ts, result.unbind()):
+                        for t, r in zip(ts_i, r_i.unbind()):
+                            self.assertEqual(fn(t, dim - 4 if dim > 0 else dim), r)
+            self.assertRaises(RuntimeError, lambda: torch.cumsum(nt, 1))
+
+        # Long panels that span several chunks, scanned along the ragged
+        # dimension and along a dimension in the middle.
+        ts = [torch.randn(i, 37, dtype=torch.double) for i in [2000, 1, 900]]
+        for nt in [nestedtensor.nested_tensor(ts),
+                   nestedtensor.as_nested_tensor(ts)]:
+            for fn in [torch.cumsum, torch.logcumsumexp]:
+                self.assertEqual(fn(nt, 1), nestedtensor.nested_tensor(
+                    [fn(t, 0) for t in ts]))
+        ts = [torch.randn(3, i, 5, dtype=torch.double) for i in [4000, 2, 700]]
+        nt = nestedtensor.nested_tensor(ts)
+        self.assertEqual(torch.cumsum(nt, 2), nestedtensor.nested_tensor(
+            [torch.cumsum(t, 1) for t in ts]))
+
+        ts = [torch.randint(-5, 5, (i,)) for i in [7, 1, 70000]]
+        for nt in [nestedtensor.nested_tensor(ts),
+                   nestedtensor.as_nested_tensor(ts)]:
+            result = torch.cumsum(nt, 1)
+            self.assertEqual(result.dtype, torch.int64)
+            self.assertEqual(result, nestedtensor.nested_tensor(
+                [torch.cumsum(t, 0) for t in ts]))
+            self.assertEqual(torch.cumsum(nt, 1, dtype=torch.float),
+                             nestedtensor.nested_tensor(
+                                 [torch.cumsum(t, 0, dtype=torch.float) for t in ts]))
+
+        # Backward
+        ts = [torch.rand(i, 3) + 0.5 for i in [4, 1, 6]]
+        for fn in [torch.cumsum, torch.cumprod, torch.logcumsumexp]:
+            inputs = [t.clone().requires_grad_() for t in ts]
+            result = fn(nestedtensor.as_nested_tensor(inputs), 1)
+            sum((r * r).sum() for r in result.unbind()).backward()
+            grads = [t.grad for t in inputs]
+            for t in inputs:
+                t.grad = None
+            sum((fn(t, 0) * fn(t, 0)).sum() for t in inputs).backward()
+            for t, g in zip(inputs, grads):
+                self.assertEqual(t.grad, g)
+
+        # Zeros go through torch.cumprod one constiuent at a time.
+        inputs = [torch.tensor([2., 0., 3.], requires_grad=True),
+                  torch.tensor([1., 4.], requires_grad=True)]
+        result = torch.cumprod(nestedtensor.as_nested_tensor(inputs), 1)
+        sum(r.sum() for r in result.unbind()).backward()
+        self.assertEqual(inputs[0].grad, torch.tensor([1., 8., 0.]))
+        self.assertEqual(inputs[1].grad, torch.tensor([5., 1.]))
+
 
 if __name__ == "__main__":
     unittest.main()